@@ -0,0 +1,468 @@
+/**
+ * Аналитическая оценка вероятности отказа каскадного кода вместо моделирования.
+ * Внешний код декодирует стирания: набор стертых слов восстанавливается тогда и только тогда,
+ * когда столбцы проверочной матрицы на позициях стираний линейно независимы (подматрица полного ранга).
+ * Перебором всех наборов стираний считается спектр невосстановимых наборов по весам, после чего
+ * вероятность отказа блока - точная сумма по весам при заданной вероятности отказа слова РС.
+ * Для внутреннего кода РС - спектр весов и точные вероятности исправления, обнаружения и ложного
+ * исправления табличным декодером 1- и 2-ошибок.
+ */
+
+#pragma once
+
+#include <cmath>     // std::pow
+#include <cstdint>   // uint64_t
+#include <array>     // std::array
+#include <cassert>   // assert
+#include <atomic>    // std::atomic
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+#include <algorithm> // std::max, std::any_of
+#include <bit>       // std::countl_zero
+#include <functional> // std::ref
+#include "hamming.hpp"
+#include "rsexh.hpp"
+
+namespace analysis {
+
+    /**
+     * Спектр стираний: по каждому весу w - количество наборов стираний и количество невосстановимых.
+     */
+    struct ErasureSpectrum
+    {
+        int mN = 0;
+        std::vector<uint64_t> mTotal;          // C(N, w).
+        std::vector<uint64_t> mUnrecoverable;  // Наборы веса w с вырожденной подматрицей.
+        uint64_t mVisited = 0;                 // Пройдено наборов полного ранга (объем перебора).
+
+        /**
+         * Наименьший вес невосстановимого набора (равен кодовому расстоянию).
+         */
+        int MinUnrecoverable() const
+        {
+            for (int w = 0; w <= mN; ++w) {
+                if (mUnrecoverable[w] != 0)
+                    return w;
+            }
+            return mN + 1;
+        }
+
+        /**
+         * Вероятность отказа блока, если слова стираются независимо с вероятностью p_word.
+         */
+        double FailureProbability(double p_word) const
+        {
+            double result = 0.;
+            for (int w = 0; w <= mN; ++w) {
+                if (mUnrecoverable[w] != 0)
+                    result += double(mUnrecoverable[w]) * std::pow(p_word, w) * std::pow(1. - p_word, mN - w);
+            }
+            return std::min(result, 1.);
+        }
+    };
+
+    /**
+     * Вероятность отказа слова РС длины n из символов по symbol_bits бит в двоичном симметричном канале:
+     * больше t ошибочных символов (t - глубина исправления внутреннего кода, 0 для режима только стирания).
+     * Ложные исправления внутреннего кода не учитываются: слово с необнаруженной ошибкой считается стертым.
+     */
+    inline double InnerWordFailure(double ber, int n, int t, int symbol_bits = 4)
+    {
+        const double ps = 1. - std::pow(1. - ber, symbol_bits);
+        double ok = 0.;
+        double binomial = 1.;
+        for (int k = 0; k <= t && k <= n; ++k) {
+            ok += binomial * std::pow(ps, k) * std::pow(1. - ps, n - k);
+            binomial = binomial * (n - k) / (k + 1);
+        }
+        return std::max(0., 1. - ok);
+    }
+
+    /**
+     * Перебрать все наборы стираний кода с проверочной матрицей H (R строк, N столбцов; N <= 64, R <= 64).
+     * Столбцы упаковываются в 64-битные слова; перебор - в глубину с инкрементальным базисом Гаусса:
+     * добавление столбца стоит не больше R операций XOR. Как только набор стал вырожденным, все его
+     * продолжения столбцами с большими номерами тоже вырожденные и учитываются биномиальными
+     * коэффициентами без перебора, поэтому проходятся только наборы полного ранга (веса не больше R).
+     * Поддеревья первых двух позиций распределяются между потоками.
+     */
+    inline ErasureSpectrum EnumerateErasures(const hamming::Matrix<int>& H, int threads = 0)
+    {
+        const int R = H.size();
+        assert(R > 0 && R <= 64);
+        const int N = H.at(0).size();
+        assert(N <= 64);
+        std::vector<uint64_t> columns(N, 0);
+        for (int j = 0; j < R; ++j) {
+            for (int i = 0; i < N; ++i) {
+                if (H[j][i] != 0)
+                    columns[i] |= uint64_t(1) << j;
+            }
+        }
+        std::vector<std::vector<uint64_t>> binomial(N + 1, std::vector<uint64_t>(N + 1, 0));
+        for (int n = 0; n <= N; ++n) {
+            binomial[n][0] = 1;
+            for (int k = 1; k <= n; ++k)
+                binomial[n][k] = binomial[n - 1][k - 1] + binomial[n - 1][k];
+        }
+
+        ErasureSpectrum spectrum;
+        spectrum.mN = N;
+        spectrum.mTotal = binomial[N];
+        spectrum.mUnrecoverable.assign(N + 1, 0);
+
+        // Базис: приведенные векторы и их ведущие биты; вектор depth приведен по всем предыдущим.
+        struct Worker
+        {
+            const std::vector<uint64_t>& mColumns;
+            const std::vector<std::vector<uint64_t>>& mBinomial;
+            std::vector<uint64_t> mUnrecoverable;
+            std::vector<uint64_t> mBasis;
+            std::vector<uint64_t> mPivot;
+            uint64_t mVisited = 0;
+
+            /**
+             * Добавить столбец c к базису глубины depth; false - столбец линейно зависим.
+             */
+            bool Push(int depth, int c)
+            {
+                uint64_t v = mColumns[c];
+                for (int k = 0; k < depth; ++k) {
+                    if (v & mPivot[k])
+                        v ^= mBasis[k];
+                }
+                if (v == 0)
+                    return false;
+                mBasis[depth] = v;
+                mPivot[depth] = uint64_t(1) << (63 - std::countl_zero(v));
+                return true;
+            }
+
+            /**
+             * Продолжить набор полного ранга из depth столбцов (последний - last).
+             */
+            void Extend(int depth, int last)
+            {
+                mVisited++;
+                const int N = mColumns.size();
+                for (int c = last + 1; c < N; ++c) {
+                    if (Push(depth, c)) {
+                        Extend(depth + 1, c);
+                        continue;
+                    }
+                    // Все наборы = текущий + c + любые j столбцов правее c - вырожденные.
+                    const int rest = N - 1 - c;
+                    for (int j = 0; j <= rest; ++j)
+                        mUnrecoverable[depth + 1 + j] += mBinomial[rest][j];
+                }
+            }
+        };
+
+        const int count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        // Задача t - наборы, начинающиеся с пары (t / N, t % N), t / N < t % N; плюс наборы из одного столбца.
+        std::atomic<int> next{0};
+        std::vector<Worker> workers;
+        for (int w = 0; w < count; ++w) {
+            workers.push_back(Worker{columns, binomial, std::vector<uint64_t>(N + 1, 0), std::vector<uint64_t>(R + 1, 0),
+                                     std::vector<uint64_t>(R + 1, 0)});
+        }
+        auto work = [&](Worker& worker) {
+            for (int task = next.fetch_add(1, std::memory_order_relaxed); task < N * N;
+                 task = next.fetch_add(1, std::memory_order_relaxed)) {
+                const int a = task / N;
+                const int b = task % N;
+                if (b < a)
+                    continue;
+                if (!worker.Push(0, a)) {
+                    // Нулевой столбец: стирание этой позиции не восстанавливается вместе с любыми другими.
+                    if (a == b) {
+                        const int rest = N - 1 - a;
+                        for (int j = 0; j <= rest; ++j)
+                            worker.mUnrecoverable[1 + j] += worker.mBinomial[rest][j];
+                    }
+                    continue;
+                }
+                if (a == b) {
+                    worker.mVisited++;
+                    continue;
+                }
+                if (worker.Push(1, b))
+                    worker.Extend(2, b);
+                else {
+                    const int rest = N - 1 - b;
+                    for (int j = 0; j <= rest; ++j)
+                        worker.mUnrecoverable[2 + j] += worker.mBinomial[rest][j];
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int w = 1; w < count; ++w)
+            pool.emplace_back(work, std::ref(workers[w]));
+        work(workers[0]);
+        for (auto& thread : pool)
+            thread.join();
+        for (const auto& worker : workers) {
+            spectrum.mVisited += worker.mVisited;
+            for (int w = 0; w <= N; ++w)
+                spectrum.mUnrecoverable[w] += worker.mUnrecoverable[w];
+        }
+        return spectrum;
+    }
+
+    /**
+     * Биномиальный коэффициент C(n, k) (точно до n = 64).
+     */
+    inline uint64_t Binomial(int n, int k)
+    {
+        if (k < 0 || k > n)
+            return 0;
+        uint64_t result = 1;
+        for (int i = 1; i <= k; ++i)
+            result = result * (n - k + i) / i;
+        return result;
+    }
+
+    /**
+     * Спектр весов кода РС и распределение исходов декодирования по весу вектора ошибки.
+     * Декодер с ограниченным расстоянием t (t < D / 2) на векторе ошибки веса w:
+     * w <= t - исправление; синдром в шаре радиуса t вокруг ненулевого кодового слова - ложное
+     * исправление (при совпадении с кодовым словом - необнаруженная ошибка); иначе - обнаруженный отказ.
+     */
+    struct InnerSpectrum
+    {
+        int mN = 0;
+        int mR = 0;
+        int mT = 0;
+        int mQ = 0;
+        std::vector<uint64_t> mWeights;       // A_w - кодовых слов веса w.
+        std::vector<uint64_t> mUndetected;    // Векторов ошибки веса w, равных кодовому слову.
+        std::vector<uint64_t> mMiscorrected;  // Векторов ошибки веса w в шаре радиуса 1..t вокруг кодового слова.
+
+        /**
+         * Векторов веса w всего.
+         */
+        uint64_t Patterns(int w) const
+        {
+            uint64_t result = Binomial(mN, w);
+            for (int i = 0; i < w; ++i)
+                result *= mQ - 1;
+            return result;
+        }
+
+        struct Outcome
+        {
+            double mCorrect = 0.;      // Слово исправлено или не искажено.
+            double mDetected = 0.;     // Отказ: слово стирается для внешнего кода.
+            double mMiscorrected = 0.; // Ложное исправление.
+            double mUndetected = 0.;   // Искаженное слово с нулевым синдромом.
+        };
+
+        /**
+         * Вероятности исходов в q-ичном симметричном канале с вероятностью ошибки символа ps
+         * (ошибочный символ равновероятно принимает любое из q - 1 неверных значений).
+         */
+        Outcome Probabilities(double ps) const
+        {
+            Outcome result;
+            for (int w = 0; w <= mN; ++w) {
+                const double pattern = std::pow(ps / (mQ - 1), w) * std::pow(1. - ps, mN - w);
+                if (w <= mT)
+                    result.mCorrect += double(Patterns(w)) * pattern;
+                result.mMiscorrected += double(mMiscorrected[w]) * pattern;
+                result.mUndetected += double(mUndetected[w]) * pattern;
+            }
+            result.mDetected = std::max(0., 1. - result.mCorrect - result.mMiscorrected - result.mUndetected);
+            return result;
+        }
+
+        /**
+         * То же для двоичного симметричного канала: ps = 1 - (1 - ber)^symbol_bits. Ненулевые ошибки
+         * символа в таком канале не равновероятны, поэтому результат - приближение q-ичным каналом.
+         */
+        Outcome ProbabilitiesForBer(double ber, int symbol_bits = 4) const
+        {
+            return Probabilities(1. - std::pow(1. - ber, symbol_bits));
+        }
+    };
+
+    /**
+     * Спектр кода РС (n, n - r) над GF(q) с декодированием до t ошибок. Код МДР, поэтому
+     * A_w = C(n, w) * sum_{j=0}^{w-d} (-1)^j C(w, j) (q^{w-d+1-j} - 1), d = r + 1.
+     * Ложные исправления: векторы веса w на расстоянии s = 1..t от кодового слова веса h;
+     * их число - сумма по i (обнулено символов слова), k (заменено на другое ненулевое),
+     * j (добавлено вне носителя) с i + k + j = s и w = h - i + j.
+     */
+    inline InnerSpectrum RsSpectrum(int n, int r, int t, int q = 16)
+    {
+        const int d = r + 1;
+        assert(2 * t < d);
+        InnerSpectrum spectrum;
+        spectrum.mN = n;
+        spectrum.mR = r;
+        spectrum.mT = t;
+        spectrum.mQ = q;
+        spectrum.mWeights.assign(n + 1, 0);
+        spectrum.mUndetected.assign(n + 1, 0);
+        spectrum.mMiscorrected.assign(n + 1, 0);
+        auto power = [](int64_t base, int e) {
+            int64_t result = 1;
+            for (int i = 0; i < e; ++i)
+                result *= base;
+            return result;
+        };
+        spectrum.mWeights[0] = 1;
+        for (int w = d; w <= n; ++w) {
+            int64_t sum = 0;
+            for (int j = 0; j <= w - d; ++j) {
+                const int64_t term = int64_t(Binomial(w, j)) * (power(q, w - d + 1 - j) - 1);
+                sum += (j % 2 == 0) ? term : -term;
+            }
+            spectrum.mWeights[w] = Binomial(n, w) * uint64_t(sum);
+        }
+        for (int h = d; h <= n; ++h) {
+            spectrum.mUndetected[h] += spectrum.mWeights[h];
+            for (int s = 1; s <= t; ++s) {
+                for (int i = 0; i <= s && i <= h; ++i) {
+                    for (int k = 0; i + k <= s && i + k <= h; ++k) {
+                        const int j = s - i - k;
+                        if (j > n - h)
+                            continue;
+                        const uint64_t ways = Binomial(h, i) * Binomial(h - i, k) * uint64_t(power(q - 2, k)) *
+                                              Binomial(n - h, j) * uint64_t(power(q - 1, j));
+                        spectrum.mMiscorrected[h - i + j] += spectrum.mWeights[h] * ways;
+                    }
+                }
+            }
+        }
+        return spectrum;
+    }
+
+    /**
+     * Классы синдромов табличного декодера РС.
+     */
+    struct SyndromeClasses
+    {
+        uint64_t mCorrected1 = 0;    // Векторов ошибки веса 1, исправленных декодером.
+        uint64_t mCorrected2 = 0;    // Векторов ошибки веса 2, исправленных декодером.
+        uint64_t mCollisions = 0;    // Совпавших синдромов векторов веса <= t (шары пересекаются).
+        uint64_t mWrong = 0;         // Вектор веса <= t не исправлен либо исправлен не в нулевое слово.
+        uint64_t mOutside = 0;       // Проверено синдромов вне шаров радиуса t.
+        uint64_t mOutsideDecoded = 0; // Из них декодер "исправил" (должно быть 0).
+        uint64_t mBall = 0;          // Синдромов в шарах радиуса t, включая нулевой.
+    };
+
+    /**
+     * Проверить табличный декодер code.Correct() по смежным классам кода РС.
+     * 1. Синдромы всех векторов ошибки веса <= t упакованно считаются быстрой арифметикой GF
+     *    (по q бит на компоненту) и отмечаются в битовой карте всех q^R синдромов.
+     * 2. Каждый такой вектор подается настоящему декодеру: он должен вернуть нулевое слово.
+     * 3. Синдромы вне шаров - векторы ошибки на проверочных позициях K..N-1 (их подматрица H обратима,
+     *    поэтому каждый синдром встречается ровно один раз) с шагом stride: декодер должен отказать.
+     *    stride = 1 - полный перебор q^R синдромов; для R = 6 это минуты на одном ядре.
+     * Работа шагов 2 и 3 делится на порции между потоками. Если проверки прошли, декодер ведет себя
+     * как декодер с ограниченным расстоянием, и к нему применим RsSpectrum().
+     */
+    template <typename Code>
+    SyndromeClasses ClassifySyndromes(const Code& code, rsexh::CorrectionMode mode, int64_t stride = 1, int threads = 0)
+    {
+        constexpr int N = Code::N;
+        constexpr int R = Code::R;
+        constexpr int K = Code::K;
+        constexpr int bits = 4;
+        constexpr int64_t total = int64_t(1) << (bits * R);
+        const int t = int(mode);
+        // Упакованный синдром значения x (представление "индекс + 1") на позиции j.
+        std::vector<std::array<uint32_t, N + 1>> columns(N);
+        for (int j = 0; j < N; ++j) {
+            for (int x = 1; x <= N; ++x) {
+                for (int i = 0; i < R; ++i) {
+                    const int c = code.mFast.Mult(code.mFast.FromValue(x), code.mFast.Exp((j * (i + 1)) % N));
+                    columns[j][x] |= uint32_t(c) << (bits * i);
+                }
+            }
+        }
+        // Векторы ошибки веса <= t: (позиция, значение) пары; вторая позиция -1 для веса 1.
+        struct Leader
+        {
+            int mPos1, mValue1, mPos2, mValue2;
+        };
+        std::vector<Leader> leaders;
+        for (int i = 0; i < N && t >= 1; ++i) {
+            for (int x = 1; x <= N; ++x) {
+                leaders.push_back({i, x, -1, 0});
+                for (int k = i + 1; k < N && t >= 2; ++k) {
+                    for (int y = 1; y <= N; ++y)
+                        leaders.push_back({i, x, k, y});
+                }
+            }
+        }
+        SyndromeClasses result;
+        std::vector<uint64_t> ball(total / 64 + 1, 0);
+        auto mark = [&ball, &result](uint32_t syndrome) {
+            uint64_t& word = ball[syndrome / 64];
+            const uint64_t bit = uint64_t(1) << (syndrome % 64);
+            result.mCollisions += (word & bit) != 0;
+            word |= bit;
+        };
+        mark(0);
+        for (const auto& l : leaders)
+            mark(columns[l.mPos1][l.mValue1] ^ (l.mPos2 >= 0 ? columns[l.mPos2][l.mValue2] : 0));
+        result.mBall = leaders.size() + 1 - result.mCollisions;
+
+        const int count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        constexpr int64_t chunk = 1024;
+        const int64_t outside_tasks = (total + stride - 1) / stride;
+        const int64_t tasks = int64_t(leaders.size()) + outside_tasks;
+        std::atomic<int64_t> next{0};
+        std::vector<SyndromeClasses> partial(count);
+        auto work = [&](SyndromeClasses& classes) {
+            std::vector<int> v(N);
+            for (int64_t begin = next.fetch_add(chunk, std::memory_order_relaxed); begin < tasks;
+                 begin = next.fetch_add(chunk, std::memory_order_relaxed)) {
+                for (int64_t task = begin; task < std::min(begin + chunk, tasks); ++task) {
+                    std::fill(v.begin(), v.end(), 0);
+                    if (task < int64_t(leaders.size())) {
+                        const auto& l = leaders[task];
+                        v[l.mPos1] = l.mValue1;
+                        if (l.mPos2 >= 0)
+                            v[l.mPos2] = l.mValue2;
+                        const auto status = code.Correct(v, mode);
+                        const bool is_zero = std::all_of(v.begin(), v.end(), [](int el) { return el == 0; });
+                        if (status == rsexh::InnerStatus::Corrected1 && l.mPos2 < 0 && is_zero)
+                            classes.mCorrected1++;
+                        else if (status == rsexh::InnerStatus::Corrected2 && l.mPos2 >= 0 && is_zero)
+                            classes.mCorrected2++;
+                        else
+                            classes.mWrong++;
+                        continue;
+                    }
+                    const int64_t index = (task - int64_t(leaders.size())) * stride;
+                    uint32_t syndrome = 0;
+                    for (int k = 0; k < R; ++k) {
+                        v[K + k] = (index >> (bits * k)) & N;
+                        syndrome ^= columns[K + k][v[K + k]];
+                    }
+                    if ((ball[syndrome / 64] >> (syndrome % 64)) & 1)
+                        continue;
+                    classes.mOutside++;
+                    classes.mOutsideDecoded += code.Correct(v, mode) != rsexh::InnerStatus::Failed;
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int w = 1; w < count; ++w)
+            pool.emplace_back(work, std::ref(partial[w]));
+        work(partial[0]);
+        for (auto& thread : pool)
+            thread.join();
+        for (const auto& classes : partial) {
+            result.mCorrected1 += classes.mCorrected1;
+            result.mCorrected2 += classes.mCorrected2;
+            result.mWrong += classes.mWrong;
+            result.mOutside += classes.mOutside;
+            result.mOutsideDecoded += classes.mOutsideDecoded;
+        }
+        return result;
+    }
+
+} // namespace analysis
@@ -0,0 +1,391 @@
+/**
+ * Микробенчмарки горячих путей кодека: арифметика GF, синдром, кодирование и декодирование РС,
+ * исправление 1- и 2-ошибок по LUT, внешний код по числу стираний, построение RsExh.
+ * Для каждого теста: нс на операцию, такты на операцию и на байт, выделений памяти на операцию.
+ * Результат - таблица и JSON; JSON можно сравнить с сохраненным базовым прогоном.
+ *
+ * rsexh_bench [--filter substr] [--min-time seconds] [--json file] [--baseline file] [--tolerance fraction]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "rsexh.hpp"
+
+namespace {
+
+   std::atomic<long long> g_allocations{0};
+
+   /**
+    * Счетчик тактов (TSC: опорная частота, а не текущая частота ядра); 0 - счетчика нет.
+    */
+   inline uint64_t Cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return 0;
+#endif
+   }
+
+   /**
+    * Не дать компилятору выбросить вычисление value.
+    */
+   template <typename T>
+   inline void Keep(const T& value) {
+      asm volatile("" : : "g"(&value) : "memory");
+   }
+
+   struct Result {
+      std::string mName;
+      long long mIterations = 0;
+      double mNsPerOp = 0.;
+      double mCyclesPerOp = 0.;
+      double mBytesPerOp = 0.;
+      double mAllocsPerOp = 0.;
+
+      double CyclesPerByte() const { return mBytesPerOp > 0. ? mCyclesPerOp / mBytesPerOp : 0.; }
+   };
+
+   struct Options {
+      std::string mFilter;
+      double mMinTime = 0.2;
+      std::string mJson;
+      std::string mBaseline;
+      double mTolerance = 0.10;
+   };
+
+   /**
+    * Прогнать f() столько раз, чтобы замер длился не меньше min_time; лучший из трех замеров.
+    * f() выполняет ops операций над bytes байтами данных за вызов.
+    */
+   template <typename F>
+   Result Measure(const std::string& name, int ops, double bytes, double min_time, F&& f) {
+      Result result;
+      result.mName = name;
+      result.mBytesPerOp = bytes / ops;
+      f(); // Прогрев: таблицы и кеши.
+      long long iterations = 1;
+      for (;;) {
+         const auto start = std::chrono::steady_clock::now();
+         for (long long i = 0; i < iterations; ++i)
+            f();
+         const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         if (seconds >= min_time / 4 || iterations >= (1LL << 40))
+            break;
+         iterations *= seconds > 0. ? std::min(10., std::max(2., min_time / 4 / seconds)) : 10.;
+      }
+      result.mIterations = iterations;
+      result.mNsPerOp = 1.e30;
+      for (int run = 0; run < 3; ++run) {
+         const long long allocations = g_allocations.load(std::memory_order_relaxed);
+         const uint64_t cycles = Cycles();
+         const auto start = std::chrono::steady_clock::now();
+         for (long long i = 0; i < iterations; ++i)
+            f();
+         const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+         const double total_ops = double(iterations) * ops;
+         if (ns / total_ops < result.mNsPerOp) {
+            result.mNsPerOp = ns / total_ops;
+            result.mCyclesPerOp = (Cycles() - cycles) / total_ops;
+            result.mAllocsPerOp = (g_allocations.load(std::memory_order_relaxed) - allocations) / total_ops;
+         }
+      }
+      return result;
+   }
+
+   void WriteJson(std::ostream& out, const std::vector<Result>& results) {
+      out << "[\n";
+      for (std::size_t i = 0; i < results.size(); ++i) {
+         const auto& r = results[i];
+         out << "  {\"name\": \"" << r.mName << "\", \"iterations\": " << r.mIterations << ", \"ns_per_op\": " << r.mNsPerOp
+             << ", \"cycles_per_op\": " << r.mCyclesPerOp << ", \"bytes_per_op\": " << r.mBytesPerOp
+             << ", \"cycles_per_byte\": " << r.CyclesPerByte() << ", \"allocs_per_op\": " << r.mAllocsPerOp
+             << (i + 1 < results.size() ? "},\n" : "}\n");
+      }
+      out << "]\n";
+   }
+
+   /**
+    * Прочитать ns_per_op из JSON, записанного WriteJson (одна запись на строку).
+    */
+   std::map<std::string, double> ReadBaseline(const std::string& path) {
+      std::map<std::string, double> baseline;
+      std::ifstream in{path};
+      for (std::string line; std::getline(in, line);) {
+         const auto name = line.find("\"name\": \"");
+         const auto ns = line.find("\"ns_per_op\": ");
+         if (name == std::string::npos || ns == std::string::npos)
+            continue;
+         const auto begin = name + 9;
+         baseline[line.substr(begin, line.find('"', begin) - begin)] = std::atof(line.c_str() + ns + 13);
+      }
+      return baseline;
+   }
+
+   /**
+    * Слово РС с ошибками value на позициях positions (сложение в поле; значения в представлении "индекс + 1").
+    */
+   std::vector<int> WithErrors(const rsexh::RsExh& code, std::vector<int> v, const std::vector<int>& positions, int value) {
+      for (const int pos : positions)
+         v[pos] = code.mFast.ToValue(code.mFast.FromValue(v[pos]) ^ code.mFast.FromValue(value));
+      return v;
+   }
+
+   // Замена глобальных new/delete для подсчета аллокаций - полным набором (массивы, размер, выравнивание),
+   // чтобы каждая пара new/delete шла через одну и ту же пару malloc/free.
+   void* CountedAllocate(std::size_t size, std::size_t alignment = 0) {
+      g_allocations.fetch_add(1, std::memory_order_relaxed);
+      size = size ? size : 1;
+      if (alignment > alignof(std::max_align_t))
+         return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+      return std::malloc(size);
+   }
+
+   void* CountedAllocateOrThrow(std::size_t size, std::size_t alignment = 0) {
+      if (void* p = CountedAllocate(size, alignment))
+         return p;
+      throw std::bad_alloc{};
+   }
+
+}
+
+void* operator new(std::size_t size) { return CountedAllocateOrThrow(size); }
+void* operator new[](std::size_t size) { return CountedAllocateOrThrow(size); }
+void* operator new(std::size_t size, std::align_val_t al) { return CountedAllocateOrThrow(size, std::size_t(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return CountedAllocateOrThrow(size, std::size_t(al)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+int main(int argc, char* argv[]) {
+   Options options;
+   for (int i = 1; i + 1 < argc; i += 2) {
+      const std::string key = argv[i];
+      const std::string value = argv[i + 1];
+      if (key == "--filter")
+         options.mFilter = value;
+      else if (key == "--min-time")
+         options.mMinTime = std::atof(value.c_str());
+      else if (key == "--json")
+         options.mJson = value;
+      else if (key == "--baseline")
+         options.mBaseline = value;
+      else if (key == "--tolerance")
+         options.mTolerance = std::atof(value.c_str());
+      else {
+         std::cerr << "Usage: " << argv[0] << " [--filter substr] [--min-time seconds] [--json file] [--baseline file] [--tolerance fraction]\n";
+         return 1;
+      }
+   }
+
+   static rsexh::RsExh code;
+   constexpr int N = rsexh::RsExh::N;
+   constexpr int K = rsexh::RsExh::K;
+   constexpr int R = rsexh::RsExh::R;
+   constexpr int M2 = rsexh::RsExh::M2;
+   code.mHammingCode.SwitchToSystematic(false);
+   const auto& gf = code.mGf;
+   const auto& fast = code.mFast;
+
+   // Входные данные: фиксированная псевдослучайная последовательность.
+   uint64_t state = 1;
+   auto next = [&state]() {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      return int(state >> 33);
+   };
+   constexpr int kOps = 256;
+   std::vector<int> index_a(kOps), index_b(kOps), vec_a(kOps), vec_b(kOps);
+   std::vector<gf::State> state_a, state_b;
+   for (int i = 0; i < kOps; ++i) {
+      index_a[i] = next() % (N + 1) - 1; // Индексы -1..N-1: -1 - нулевой элемент.
+      index_b[i] = next() % (N + 1) - 1;
+      vec_a[i] = next() & N;
+      vec_b[i] = next() & N;
+      state_a.push_back(gf.GetElement(index_a[i]));
+      state_b.push_back(gf.GetElement(index_b[i]));
+   }
+   std::vector<int> info(K);
+   for (auto& el : info)
+      el = next() % (N + 1);
+   const auto codeword = rsexh::Encode(info, gf);
+   const std::vector<int> error1 = WithErrors(code, codeword, {7}, 5);
+   const std::vector<int> error2_best = WithErrors(code, codeword, {0, 9}, 3);
+   // Худший случай цикла сдвигов: первая ошибка на позиции N - 2, найдется на последнем сдвиге.
+   const std::vector<int> error2_worst = WithErrors(code, codeword, {N - 2, N - 1}, 11);
+   const std::vector<int> error3 = WithErrors(code, codeword, {1, 6, 12}, 9);
+   const rsexh::DirectCorrector<rsexh::RsExh> direct{code};
+
+   hamming::CodeWord<int, M2> block(code.mHammingCode.K);
+   for (auto& el : block) {
+      el.mStatus = hamming::SymbolStatus::Normal;
+      for (auto& symbol : el.mSymbol)
+         symbol = next() & N;
+   }
+   rsexh::Matrix<int> encoded_block;
+   code.EncodeBlock(block, encoded_block);
+   const double block_bytes = code.mHammingCode.K * M2 * 0.5; // Полубайты информации блока.
+   auto& outer = code.mHammingCode;
+   const auto outer_codeword = outer.Encode(block);
+
+   std::vector<Result> results;
+   auto run = [&](const std::string& name, int ops, double bytes, auto&& f) {
+      if (!options.mFilter.empty() && name.find(options.mFilter) == std::string::npos)
+         return;
+      results.push_back(Measure(name, ops, bytes, options.mMinTime, f));
+      const auto& r = results.back();
+      std::cout << std::left << std::setw(28) << r.mName << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+                << r.mNsPerOp << " ns/op" << std::setw(12) << r.mCyclesPerOp << " cycles/op" << std::setw(12)
+                << r.CyclesPerByte() << " cycles/B" << std::setw(12) << r.mAllocsPerOp << " allocs/op" << std::endl;
+   };
+
+   run("gf_index_add", kOps, 0., [&] {
+      int acc = 0;
+      for (int i = 0; i < kOps; ++i)
+         acc ^= gf.Add(index_a[i], index_b[i]);
+      Keep(acc);
+   });
+   run("gf_index_mult", kOps, 0., [&] {
+      int acc = 0;
+      for (int i = 0; i < kOps; ++i)
+         acc ^= gf.Mult(index_a[i], index_b[i]);
+      Keep(acc);
+   });
+   run("gf_state_add", kOps, 0., [&] {
+      for (int i = 0; i < kOps; ++i)
+         Keep(gf.Add(state_a[i], state_b[i]));
+   });
+   run("gf_state_mult", kOps, 0., [&] {
+      for (int i = 0; i < kOps; ++i)
+         Keep(gf.Mult(state_a[i], state_b[i]));
+   });
+   run("gf_vector_add", kOps, 0., [&] {
+      int acc = 0;
+      for (int i = 0; i < kOps; ++i)
+         acc ^= gf::FastGF2<4>::Add(vec_a[i], vec_b[i]);
+      Keep(acc);
+   });
+   run("gf_vector_mult", kOps, 0., [&] {
+      int acc = 0;
+      for (int i = 0; i < kOps; ++i)
+         acc ^= fast.Mult(vec_a[i], vec_b[i]);
+      Keep(acc);
+   });
+   run("rs_syndrome", 1, N * 0.5, [&] { Keep(rsexh::CalculateSyndrome(error1, R, gf)); });
+   run("rs_syndrome_packed", 1, N * 0.5, [&] { Keep(direct.Syndrome(error1)); });
+   run("rs_encode", 1, K * 0.5, [&] { Keep(rsexh::Encode(info, gf)); });
+   std::vector<int> parity(R);
+   run("rs_encode_systematic", 1, K * 0.5, [&] {
+      code.EncodeSystematic(info.data(), parity.data());
+      Keep(parity);
+   });
+   run("rs_decode", 1, N * 0.5, [&] { Keep(rsexh::Decode(codeword, R, gf)); });
+   std::vector<int> word(N);
+   auto correct = [&](const std::vector<int>& input, auto&& decoder) {
+      return [&input, &word, decoder] {
+         std::copy(input.begin(), input.end(), word.begin());
+         Keep(decoder(word));
+      };
+   };
+   auto lut = [](std::vector<int>& v) { return code.Correct(v); };
+   auto table = [&direct](std::vector<int>& v) { return direct.Correct(v); };
+   run("rs_correct_clean", 1, N * 0.5, correct(codeword, lut));
+   run("rs_correct1", 1, N * 0.5, correct(error1, lut));
+   run("rs_correct2_first_shift", 1, N * 0.5, correct(error2_best, lut));
+   run("rs_correct2_last_shift", 1, N * 0.5, correct(error2_worst, lut));
+   run("rs_correct3_failure", 1, N * 0.5, correct(error3, lut));
+   run("rs_correct2_direct", 1, N * 0.5, correct(error2_worst, table));
+   run("outer_encode", 1, block_bytes, [&] { Keep(outer.Encode(block)); });
+   for (int erased = 0; erased <= outer.N - outer.K; ++erased) {
+      auto received = outer_codeword;
+      for (int e = 0; e < erased; ++e) {
+         received[(5 * e + 3) % outer.N].mStatus = hamming::SymbolStatus::Erased;
+         received[(5 * e + 3) % outer.N].mSymbol.fill(-1);
+      }
+      hamming::CodeWord<int, M2> work;
+      run("outer_copy_decode_e" + std::to_string(erased), 1, block_bytes, [&] {
+         work = received;
+         int count = 0;
+         Keep(outer.Decode(work, count));
+      });
+   }
+   run("block_encode", 1, block_bytes, [&] {
+      code.EncodeBlock(block, encoded_block);
+      Keep(encoded_block);
+   });
+   rsexh::Matrix<int> received_block;
+   hamming::CodeWord<int, M2> decoded;
+   run("block_decode_clean", 1, block_bytes, [&] {
+      received_block = encoded_block;
+      int erased = 0;
+      Keep(code.DecodeBlock(received_block, decoded, erased));
+   });
+   // Табличный режим слов РС (как в потоковом кодировании): систематический код, прямая индексация.
+   static rsexh::RsExh direct_code;
+   direct_code.mHammingCode.SwitchToSystematic(false);
+   direct_code.SwitchToDirect(true);
+   rsexh::Matrix<int> direct_block;
+   run("block_encode_direct", 1, block_bytes, [&] {
+      direct_code.EncodeBlock(block, direct_block);
+      Keep(direct_block);
+   });
+   run("block_decode_clean_direct", 1, block_bytes, [&] {
+      received_block = direct_block;
+      int erased = 0;
+      Keep(direct_code.DecodeBlock(received_block, decoded, erased));
+   });
+   {
+      // Построение печатает проверку полинома в std::cerr; на время замера вывод отключается.
+      std::ostringstream quiet;
+      auto* saved = std::cerr.rdbuf(quiet.rdbuf());
+      run("rsexh_construct", 1, 0., [] {
+         rsexh::RsExh instance;
+         Keep(instance.mSysParity);
+      });
+      std::cerr.rdbuf(saved);
+   }
+
+   if (!options.mJson.empty()) {
+      std::ofstream out{options.mJson};
+      WriteJson(out, results);
+   }
+   if (options.mBaseline.empty())
+      return 0;
+   const auto baseline = ReadBaseline(options.mBaseline);
+   int regressions = 0;
+   std::cout << "\nComparison with " << options.mBaseline << " (tolerance " << options.mTolerance * 100 << "%):\n";
+   for (const auto& r : results) {
+      const auto it = baseline.find(r.mName);
+      if (it == baseline.end() || it->second <= 0.)
+         continue;
+      const double ratio = r.mNsPerOp / it->second;
+      const bool is_regression = ratio > 1. + options.mTolerance;
+      regressions += is_regression;
+      std::cout << std::left << std::setw(28) << r.mName << std::right << std::setw(12) << it->second << " -> "
+                << std::setw(12) << r.mNsPerOp << " ns/op  x" << std::setprecision(3) << ratio
+                << (is_regression ? "  REGRESSION" : "") << std::setprecision(2) << '\n';
+   }
+   return regressions > 0 ? 2 : 0;
+}
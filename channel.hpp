@@ -0,0 +1,411 @@
+/**
+ * Модели канала. Канал получает последовательность из count символов по 4 бита (полубайты РС)
+ * и сообщает приемнику события: инверсию бит символа, стирание диапазона символов,
+ * надежность символа. Приемник (Sink) решает, куда их применить: к кодовым словам РС
+ * (WordsTarget) или к плоскому буферу канала (BufferTarget).
+ * Модели не хранят состояния между вызовами (состояние канала в начале вызова выбирается
+ * из стационарного распределения), поэтому одна модель безопасно используется всеми потоками.
+ * Двоичный симметричный канал, Гилберт - Эллиотт и стирание пакетов разреженные:
+ * случайные числа тратятся на события, а не на биты.
+ */
+
+#pragma once
+
+#include <cstdint>   // uint64_t
+#include <cstddef>   // std::size_t
+#include <cmath>     // std::ldexp, std::log, std::log1p, std::sqrt, std::cos, std::sin, std::pow, std::erfc
+#include <limits>    // std::numeric_limits
+#include <vector>    // std::vector
+#include <algorithm> // std::min
+#include <numbers>   // std::numbers::pi
+#include "rsexh.hpp"
+
+namespace channel {
+
+    /**
+     * Бит на символ канала (полубайт).
+     */
+    inline constexpr int kSymbolBits = 4;
+
+    /**
+     * Счетный генератор: i-е число потока - биективное перемешивание (финализатор SplitMix64)
+     * ключа потока и номера i. Потоки с разными ключами независимы, перехода по состоянию нет.
+     */
+    class CounterRng
+    {
+    public:
+        CounterRng(uint64_t seed, uint64_t stream)
+            : mKey{Mix(seed ^ Mix(stream + kGolden))}
+        {
+        }
+
+        uint64_t Next()
+        {
+            return Mix(mKey + (++mCounter) * kGolden);
+        }
+
+        /**
+         * Порог для Bernoulli: событие с вероятностью p - Next() < Threshold(p).
+         */
+        static uint64_t Threshold(double p)
+        {
+            if (p <= 0.)
+                return 0;
+            if (p >= 1.)
+                return ~uint64_t(0);
+            return static_cast<uint64_t>(std::ldexp(p, 64));
+        }
+
+        bool Bernoulli(uint64_t threshold)
+        {
+            return Next() < threshold;
+        }
+
+        /**
+         * Равномерное число из (0, 1], 53 бита.
+         */
+        double Uniform()
+        {
+            return std::ldexp(double((Next() >> 11) + 1), -53);
+        }
+
+    private:
+        static constexpr uint64_t kGolden = 0x9E3779B97F4A7C15ull;
+
+        static uint64_t Mix(uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t mKey;
+        uint64_t mCounter = 0;
+    };
+
+    /**
+     * Расстояния между событиями с вероятностью p на испытание: число испытаний без события перед
+     * очередным распределено геометрически, G = floor(ln U / ln(1 - p)).
+     * Одно случайное число на событие вместо одного на испытание: при p = 0.005 это в 200 раз меньше вызовов.
+     */
+    class GeometricSkip
+    {
+    public:
+        explicit GeometricSkip(double p)
+            : mP{p}, mLogQ{p > 0. && p < 1. ? std::log1p(-p) : 0.}
+        {
+        }
+
+        /**
+         * Количество испытаний без события перед следующим; u - равномерное из (0, 1].
+         */
+        long long Gap(double u) const
+        {
+            if (mP <= 0.)
+                return std::numeric_limits<long long>::max();
+            if (mP >= 1.)
+                return 0;
+            const double gap = std::log(u) / mLogQ;
+            return gap < 9.e18 ? static_cast<long long>(gap) : std::numeric_limits<long long>::max();
+        }
+
+    private:
+        double mP;
+        double mLogQ;
+    };
+
+    /**
+     * Приемник событий канала - кодовые слова РС одинаковой длины (символ i - слово i / n, позиция i % n).
+     * Стертые слова очищаются (пустое слово декодер считает стертым).
+     */
+    class WordsTarget
+    {
+    public:
+        /**
+         * @param reliability Если задан - надежности символов (для мягких решений), размер - число символов.
+         */
+        explicit WordsTarget(rsexh::Matrix<int>& v, std::vector<float>* reliability = nullptr)
+            : mWords{v}, mWordSymbols{v.empty() ? 1 : v[0].size()}, mReliability{reliability}
+        {
+        }
+
+        std::size_t Symbols() const { return mWords.size() * mWordSymbols; }
+
+        void Flip(std::size_t i, int mask)
+        {
+            auto& word = mWords[i / mWordSymbols];
+            if (!word.empty())
+                word[i % mWordSymbols] ^= mask;
+        }
+
+        void Erase(std::size_t begin, std::size_t end)
+        {
+            for (std::size_t w = begin / mWordSymbols; w * mWordSymbols < end && w < mWords.size(); ++w)
+                mWords[w].clear();
+        }
+
+        void Reliability(std::size_t i, float r)
+        {
+            if (mReliability)
+                (*mReliability)[i] = r;
+        }
+
+    private:
+        rsexh::Matrix<int>& mWords;
+        std::size_t mWordSymbols;
+        std::vector<float>* mReliability;
+    };
+
+    /**
+     * Приемник событий канала - плоский буфер символов; флаги стирания и надежности - по желанию.
+     */
+    template <typename T>
+    class BufferTarget
+    {
+    public:
+        explicit BufferTarget(T* data, uint8_t* erased = nullptr, float* reliability = nullptr)
+            : mData{data}, mErased{erased}, mReliability{reliability}
+        {
+        }
+
+        void Flip(std::size_t i, int mask) { mData[i] ^= mask; }
+
+        void Erase(std::size_t begin, std::size_t end)
+        {
+            if (mErased)
+                std::fill(mErased + begin, mErased + end, uint8_t(1));
+        }
+
+        void Reliability(std::size_t i, float r)
+        {
+            if (mReliability)
+                mReliability[i] = r;
+        }
+
+    private:
+        T* mData;
+        uint8_t* mErased;
+        float* mReliability;
+    };
+
+    /**
+     * Модель канала: Apply(count, rng, sink) вносит события в count символов.
+     */
+    template <typename M>
+    concept Model = requires(const M& model, std::size_t count, CounterRng& rng, BufferTarget<uint8_t>& sink) {
+        model.Apply(count, rng, sink);
+    };
+
+    namespace detail {
+
+        /**
+         * Собирает инверсии бит в маску символа, чтобы приемник получал одно событие на символ.
+         */
+        template <typename Sink>
+        struct FlipAccumulator
+        {
+            Sink& mSink;
+            long long mSymbol = -1;
+            int mMask = 0;
+
+            void Add(long long bit)
+            {
+                const long long symbol = bit / kSymbolBits;
+                if (symbol != mSymbol) {
+                    Flush();
+                    mSymbol = symbol;
+                }
+                mMask |= 1 << (bit % kSymbolBits);
+            }
+
+            void Flush()
+            {
+                if (mMask != 0)
+                    mSink.Flip(std::size_t(mSymbol), mMask);
+                mMask = 0;
+            }
+        };
+
+        /**
+         * Независимые ошибки бит [begin, end) с вероятностью skip.
+         */
+        template <typename Rng, typename Sink>
+        inline void ScatterErrors(long long begin, long long end, const GeometricSkip& skip, Rng& rng,
+                                  FlipAccumulator<Sink>& flips)
+        {
+            for (long long pos = begin; ; ) {
+                const long long gap = skip.Gap(rng.Uniform());
+                if (gap >= end - pos)
+                    break;
+                pos += gap;
+                flips.Add(pos);
+                pos++;
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Двоичный симметричный канал: независимые ошибки бит с вероятностью mBer.
+     */
+    struct Bsc
+    {
+        double mBer = 0.;
+
+        template <typename Rng, typename Sink>
+        void Apply(std::size_t count, Rng& rng, Sink& sink) const
+        {
+            detail::FlipAccumulator<Sink> flips{sink};
+            detail::ScatterErrors(0, static_cast<long long>(count) * kSymbolBits, GeometricSkip{mBer}, rng, flips);
+            flips.Flush();
+        }
+    };
+
+    /**
+     * Канал Гилберта - Эллиотта: два состояния (хорошее и плохое) с переходами на каждом бите
+     * и своей вероятностью ошибки бита в каждом. Длительности пребывания в состояниях
+     * геометрические и разыгрываются целиком, ошибки внутри - пропусками, как в Bsc.
+     */
+    struct GilbertElliott
+    {
+        double mGoodToBad = 1.e-4;   // Вероятность перехода в плохое состояние на бите.
+        double mBadToGood = 1.e-2;   // Вероятность возврата в хорошее состояние на бите.
+        double mBerGood = 0.;
+        double mBerBad = 0.2;
+
+        /**
+         * Средняя вероятность ошибки бита (по стационарному распределению состояний).
+         */
+        double AverageBer() const
+        {
+            const double bad = mGoodToBad / (mGoodToBad + mBadToGood);
+            return bad * mBerBad + (1. - bad) * mBerGood;
+        }
+
+        template <typename Rng, typename Sink>
+        void Apply(std::size_t count, Rng& rng, Sink& sink) const
+        {
+            const long long total = static_cast<long long>(count) * kSymbolBits;
+            const GeometricSkip stay[2] = {GeometricSkip{mGoodToBad}, GeometricSkip{mBadToGood}};
+            const GeometricSkip errors[2] = {GeometricSkip{mBerGood}, GeometricSkip{mBerBad}};
+            int state = rng.Uniform() <= mGoodToBad / (mGoodToBad + mBadToGood) ? 1 : 0;
+            detail::FlipAccumulator<Sink> flips{sink};
+            for (long long pos = 0; pos < total; state ^= 1) {
+                const long long run = stay[state].Gap(rng.Uniform());
+                const long long end = run >= total - pos ? total : pos + run + 1;
+                detail::ScatterErrors(pos, end, errors[state], rng, flips);
+                pos = end;
+            }
+            flips.Flush();
+        }
+    };
+
+    /**
+     * Стирание пакетов: символы идут пакетами по mPacketSymbols, пакет теряется целиком с вероятностью mLoss.
+     */
+    struct PacketErasure
+    {
+        double mLoss = 0.;
+        int mPacketSymbols = rsexh::RsExh::N;
+
+        template <typename Rng, typename Sink>
+        void Apply(std::size_t count, Rng& rng, Sink& sink) const
+        {
+            const long long packets = (static_cast<long long>(count) + mPacketSymbols - 1) / mPacketSymbols;
+            const GeometricSkip skip{mLoss};
+            for (long long p = 0; ; ++p) {
+                const long long gap = skip.Gap(rng.Uniform());
+                if (gap >= packets - p)
+                    break;
+                p += gap;
+                const std::size_t begin = std::size_t(p) * mPacketSymbols;
+                sink.Erase(begin, std::min(count, begin + mPacketSymbols));
+            }
+        }
+    };
+
+    /**
+     * BPSK в канале с аддитивным белым гауссовым шумом и жестким решением. Надежность символа -
+     * наименьший модуль принятого отсчета среди его бит (в единицах амплитуды сигнала).
+     * Если задан порог, слово из mWordSymbols символов, в котором ненадежных символов больше,
+     * чем исправляет код РС, стирается: ошибки в нем все равно не исправить, а стирание внешний код восстановит.
+     * Шум генерируется порциями по 64 бита (преобразование Бокса - Мюллера над массивами).
+     */
+    struct BpskAwgn
+    {
+        double mEsN0Db = 6.;              // Отношение энергии бита канала к спектральной плотности шума, дБ.
+        float mErasureThreshold = 0.f;     // Порог надежности символа; 0 - без стираний.
+        int mWordSymbols = rsexh::RsExh::N;
+        int mMaxUnreliable = (rsexh::RsExh::D - 1) / 2;
+
+        /**
+         * Es/N0 канала по Eb/N0 на информационный бит и скорости кода.
+         */
+        static double EsN0Db(double eb_n0_db, double rate)
+        {
+            return eb_n0_db + 10. * std::log10(rate);
+        }
+
+        /**
+         * Вероятность ошибки бита при жестком решении: Q(sqrt(2 Es/N0)).
+         */
+        double HardBer() const
+        {
+            return 0.5 * std::erfc(std::sqrt(std::pow(10., mEsN0Db / 10.)));
+        }
+
+        template <typename Rng, typename Sink>
+        void Apply(std::size_t count, Rng& rng, Sink& sink) const
+        {
+            constexpr int kBatch = 64;
+            const float sigma = static_cast<float>(std::sqrt(0.5 / std::pow(10., mEsN0Db / 10.)));
+            const long long total = static_cast<long long>(count) * kSymbolBits;
+            float noise[kBatch];
+            double u1[kBatch / 2];
+            double u2[kBatch / 2];
+            float symbol_reliability = 0.f;
+            int mask = 0;
+            int unreliable = 0;
+            for (long long base = 0; base < total; base += kBatch) {
+                for (int i = 0; i < kBatch / 2; ++i) {
+                    u1[i] = rng.Uniform();
+                    u2[i] = rng.Uniform();
+                }
+                for (int i = 0; i < kBatch / 2; ++i) {
+                    const double r = std::sqrt(-2. * std::log(u1[i]));
+                    const double phi = 2. * std::numbers::pi * u2[i];
+                    noise[2 * i] = static_cast<float>(r * std::cos(phi));
+                    noise[2 * i + 1] = static_cast<float>(r * std::sin(phi));
+                }
+                const int bits = static_cast<int>(std::min<long long>(kBatch, total - base));
+                for (int i = 0; i < bits; ++i) {
+                    const long long bit = base + i;
+                    const int lane = bit % kSymbolBits;
+                    const float y = 1.f + sigma * noise[i]; // Передан +1 (код линейный, канал симметричный).
+                    if (lane == 0) {
+                        symbol_reliability = std::abs(y);
+                        mask = 0;
+                    } else {
+                        symbol_reliability = std::min(symbol_reliability, std::abs(y));
+                    }
+                    mask |= (y < 0.f) << lane;
+                    if (lane + 1 < kSymbolBits)
+                        continue;
+                    const std::size_t symbol = bit / kSymbolBits;
+                    if (mask != 0)
+                        sink.Flip(symbol, mask);
+                    sink.Reliability(symbol, symbol_reliability);
+                    if (mErasureThreshold > 0.f) {
+                        unreliable += symbol_reliability < mErasureThreshold;
+                        if ((symbol + 1) % mWordSymbols == 0 || symbol + 1 == count) {
+                            if (unreliable > mMaxUnreliable)
+                                sink.Erase(symbol - symbol % mWordSymbols, symbol + 1);
+                            unreliable = 0;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+} // namespace channel
@@ -0,0 +1,387 @@
+/**
+ * Безскоростной (fountain, LT) внешний код над кодовыми элементами.
+ * Кодер выдает неограниченный поток восстанавливающих символов; декодер - "очищающий" (peeling)
+ * за линейное время, с инактивацией неизвестных при остановке и решением оставшейся
+ * плотной системы методом Гаусса.
+ */
+
+#pragma once
+
+#include <cstdint>   // uint64_t
+#include <cmath>     // std::log, std::sqrt
+#include <vector>    // std::vector
+#include <unordered_map> // std::unordered_map
+#include <algorithm> // std::upper_bound, std::clamp, std::find, std::max
+#include <utility>   // std::move
+#include "hamming.hpp"
+
+namespace fountain {
+
+    /**
+     * Генератор SplitMix64: по номеру символа однозначно задает его степень и соседей.
+     */
+    struct SplitMix64
+    {
+        uint64_t mState;
+
+        uint64_t Next()
+        {
+            uint64_t z = (mState += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        double Uniform()
+        {
+            return (Next() >> 11) * 0x1.0p-53;
+        }
+    };
+
+    /**
+     * Устойчивое распределение Солитона (robust soliton) степеней для K информационных символов.
+     */
+    class RobustSoliton
+    {
+    public:
+        explicit RobustSoliton(int K, double c = 0.05, double delta = 0.05)
+            : mCdf(K)
+        {
+            assert(K > 0);
+            const double s = c * std::log(K / delta) * std::sqrt(K);
+            const int spike = std::clamp(int(K / s), 1, K);
+            std::vector<double> weight(K + 1, 0.);
+            weight[1] = 1. / K;
+            for (int d = 2; d <= K; ++d)
+                weight[d] = 1. / (d * (d - 1.));
+            for (int d = 1; d < spike; ++d)
+                weight[d] += s / (K * d);
+            weight[spike] += s * std::log(s / delta) / K;
+            double sum = 0.;
+            for (int d = 1; d <= K; ++d)
+                sum += std::max(weight[d], 0.);
+            double acc = 0.;
+            for (int d = 1; d <= K; ++d) {
+                acc += std::max(weight[d], 0.) / sum;
+                mCdf[d - 1] = acc;
+            }
+            mCdf.back() = 1.;
+        }
+
+        int Sample(double u) const
+        {
+            return int(std::upper_bound(mCdf.begin(), mCdf.end(), u) - mCdf.begin()) + 1;
+        }
+
+        int K() const { return mCdf.size(); }
+
+    private:
+        std::vector<double> mCdf;
+    };
+
+    /**
+     * Соседи (номера информационных символов) восстанавливающего символа id.
+     */
+    inline void Neighbors(const RobustSoliton& dist, uint64_t seed, uint32_t id, std::vector<int>& out)
+    {
+        SplitMix64 rng{seed ^ (uint64_t(id) * 0xd1b54a32d192ed03ULL)};
+        const int K = dist.K();
+        const int degree = std::min(dist.Sample(rng.Uniform()), K);
+        out.clear();
+        while (int(out.size()) < degree) {
+            const int n = rng.Next() % K;
+            if (std::find(out.begin(), out.end(), n) == out.end())
+                out.push_back(n);
+        }
+    }
+
+    /**
+     * Кодер: символ id - XOR соседних информационных символов. Номера не ограничены, поэтому
+     * избыточность можно менять на ходу, не перекодируя блок. Кодер хранит копию блока:
+     * временный блок (Encoder{MakeBlock()}) допустим, для большого блока копию можно избежать через std::move.
+     */
+    template <typename T, int M>
+    class Encoder
+    {
+    public:
+        Encoder(hamming::CodeWord< T, M > source, uint64_t seed = 0)
+            : mSource{std::move(source)}, mDist{int(mSource.size())}, mSeed{seed}
+        {
+        }
+
+        hamming::CodeElement< T, M > Generate(uint32_t id)
+        {
+            Neighbors(mDist, mSeed, id, mNeighbors);
+            hamming::CodeElement< T, M > result{hamming::SymbolStatus::Normal, {}};
+            for (auto n : mNeighbors)
+                result += mSource.at(n);
+            return result;
+        }
+
+    private:
+        hamming::CodeWord< T, M > mSource;
+        RobustSoliton mDist;
+        uint64_t mSeed;
+        std::vector<int> mNeighbors;
+    };
+
+    /**
+     * Декодер. Символы добавляются по одному; очистка идет по мере поступления.
+     * Когда очистка остановилась, а символов не меньше K, неизвестный символ с наибольшим числом
+     * ссылок инактивируется (становится переменной плотной системы), и очистка продолжается.
+     * Остальные символы при этом выражаются через инактивированные (маска коэффициентов).
+     */
+    template <typename T, int M>
+    class Decoder
+    {
+    public:
+        using Element = hamming::CodeElement< T, M >;
+
+        explicit Decoder(int K, uint64_t seed = 0)
+            : mDist{K}, mSeed{seed}, mState(K, State::Unknown), mValue(K), mCoef(K), mRefs(K), mByRefs(1), mBucketPos(K),
+              mUnresolved{K}
+        {
+            for (int n = 0; n < K; ++n)
+                Bucket(n);
+        }
+
+        /**
+         * Добавить принятый символ. Возвращает true, когда блок декодирован.
+         */
+        bool Add(uint32_t id, const Element& element)
+        {
+            if (mIsComplete) {
+                return true;
+            }
+            Equation eq;
+            eq.mRhs = element;
+            Neighbors(mDist, mSeed, id, eq.mNeighbors);
+            const int e = mEquations.size();
+            for (auto n : eq.mNeighbors) {
+                switch (mState[n]) {
+                case State::Resolved:
+                    eq.mRhs += mValue[n];
+                    XorMask(eq.mMask, mCoef[n]);
+                    break;
+                case State::Inactive:
+                    SetBit(eq.mMask, mInactiveIndex[n]);
+                    break;
+                case State::Unknown:
+                    eq.mRemaining++;
+                    Unbucket(n);
+                    mRefs[n].push_back(e);
+                    Bucket(n);
+                    break;
+                }
+            }
+            mEquations.push_back(std::move(eq));
+            if (mEquations.back().mRemaining == 1) {
+                mRipple.push_back(e);
+            }
+            Peel();
+            while (mUnresolved > 0 && int(mEquations.size()) >= mDist.K() && mRipple.empty()) {
+                Inactivate();
+                Peel();
+            }
+            if (mUnresolved == 0) {
+                mIsComplete = SolveInactive();
+            }
+            return mIsComplete;
+        }
+
+        bool IsComplete() const { return mIsComplete; }
+
+        /**
+         * Декодированные информационные символы (после IsComplete()).
+         */
+        const hamming::CodeWord< T, M >& Sources() const { return mValue; }
+
+        int Inactivated() const { return mInactive.size(); }
+
+    private:
+        enum class State { Unknown, Resolved, Inactive };
+        using Mask = std::vector<uint64_t>;
+
+        struct Equation
+        {
+            std::vector<int> mNeighbors;
+            Element mRhs{hamming::SymbolStatus::Normal, {}};
+            Mask mMask;          // Коэффициенты при инактивированных символах.
+            int mRemaining = 0;  // Количество неизвестных (не инактивированных) соседей.
+            bool mIsUsed = false;
+        };
+
+        static void XorMask(Mask& dst, const Mask& src)
+        {
+            if (dst.size() < src.size())
+                dst.resize(src.size(), 0);
+            for (std::size_t i = 0; i < src.size(); ++i)
+                dst[i] ^= src[i];
+        }
+
+        static void SetBit(Mask& mask, int bit)
+        {
+            if (int(mask.size()) <= bit / 64)
+                mask.resize(bit / 64 + 1, 0);
+            mask[bit / 64] ^= uint64_t(1) << (bit % 64);
+        }
+
+        static bool GetBit(const Mask& mask, int bit)
+        {
+            return int(mask.size()) > bit / 64 && ((mask[bit / 64] >> (bit % 64)) & 1);
+        }
+
+        /**
+         * Очистка: уравнение с одним неизвестным разрешает его, и он исключается из остальных уравнений.
+         * Каждое ребро графа обрабатывается один раз - линейная сложность.
+         */
+        void Peel()
+        {
+            while (!mRipple.empty()) {
+                const int e = mRipple.back();
+                mRipple.pop_back();
+                auto& eq = mEquations[e];
+                if (eq.mIsUsed || eq.mRemaining != 1) {
+                    continue;
+                }
+                int u = -1;
+                for (auto n : eq.mNeighbors) {
+                    if (mState[n] == State::Unknown) {
+                        u = n;
+                        break;
+                    }
+                }
+                eq.mIsUsed = true;
+                Unbucket(u);
+                mState[u] = State::Resolved;
+                mValue[u] = eq.mRhs;
+                mCoef[u] = eq.mMask;
+                mUnresolved--;
+                for (auto e2 : mRefs[u]) {
+                    auto& other = mEquations[e2];
+                    if (other.mIsUsed)
+                        continue;
+                    other.mRhs += mValue[u];
+                    XorMask(other.mMask, mCoef[u]);
+                    if (--other.mRemaining == 1)
+                        mRipple.push_back(e2);
+                }
+                mRefs[u].clear();
+            }
+        }
+
+        /**
+         * Поместить неизвестный символ в корзину по числу ссылок (все ссылки неизвестного символа - из
+         * неиспользованных уравнений: уравнение используется, когда в нем остается единственный неизвестный).
+         */
+        void Bucket(int n)
+        {
+            const int refs = mRefs[n].size();
+            if (int(mByRefs.size()) <= refs)
+                mByRefs.resize(refs + 1);
+            mBucketPos[n] = mByRefs[refs].size();
+            mByRefs[refs].push_back(n);
+            mMaxRefs = std::max(mMaxRefs, refs);
+        }
+
+        void Unbucket(int n)
+        {
+            auto& bucket = mByRefs[mRefs[n].size()];
+            const int last = bucket.back();
+            bucket[mBucketPos[n]] = last;
+            mBucketPos[last] = mBucketPos[n];
+            bucket.pop_back();
+        }
+
+        /**
+         * Инактивировать неизвестный символ с наибольшим числом ссылок из неиспользованных уравнений.
+         * Символ берется из непустой корзины с наибольшим номером: указатель на нее опускается не больше,
+         * чем поднимался при добавлении ссылок, поэтому выбор стоит O(1) в среднем.
+         */
+        void Inactivate()
+        {
+            while (mByRefs[mMaxRefs].empty())
+                mMaxRefs--;
+            const int best = mByRefs[mMaxRefs].back();
+            Unbucket(best);
+            const int bit = mInactive.size();
+            mInactive.push_back(best);
+            mInactiveIndex[best] = bit;
+            mState[best] = State::Inactive;
+            mUnresolved--;
+            for (auto e : mRefs[best]) {
+                auto& eq = mEquations[e];
+                if (eq.mIsUsed)
+                    continue;
+                SetBit(eq.mMask, bit);
+                if (--eq.mRemaining == 1)
+                    mRipple.push_back(e);
+            }
+            mRefs[best].clear();
+        }
+
+        /**
+         * Решить плотную систему для инактивированных символов (метод Гаусса) и подставить решение.
+         */
+        bool SolveInactive()
+        {
+            const int I = mInactive.size();
+            if (I > 0) {
+                hamming::CodeWord< T, M > free_column;
+                hamming::Matrix<int> selected;
+                for (const auto& eq : mEquations) {
+                    if (eq.mIsUsed || eq.mRemaining != 0)
+                        continue;
+                    free_column.push_back(eq.mRhs);
+                    selected.emplace_back(I, 0);
+                    for (int j = 0; j < I; ++j)
+                        selected.back()[j] = GetBit(eq.mMask, j);
+                }
+                if (int(free_column.size()) < I) {
+                    return false;
+                }
+                hamming::Gauss(free_column, selected);
+                for (int k = 0; k < I; ++k) {
+                    if (selected.at(k).at(k) == 0)
+                        return false; // Ранг неполный: нужны еще символы.
+                }
+                // Обратный ход.
+                for (int k = I - 1; k >= 0; --k) {
+                    Element value = free_column.at(k);
+                    for (int j = k + 1; j < I; ++j) {
+                        if (selected.at(k).at(j) != 0)
+                            value += mValue[mInactive[j]];
+                    }
+                    mValue[mInactive[k]] = value;
+                }
+            }
+            for (int n = 0; n < mDist.K(); ++n) {
+                if (mState[n] != State::Resolved)
+                    continue;
+                for (int j = 0; j < I; ++j) {
+                    if (GetBit(mCoef[n], j))
+                        mValue[n] += mValue[mInactive[j]];
+                }
+                mCoef[n].clear();
+            }
+            return true;
+        }
+
+        RobustSoliton mDist;
+        uint64_t mSeed;
+        std::vector<State> mState;
+        hamming::CodeWord< T, M > mValue;
+        std::vector<Mask> mCoef;
+        std::vector<std::vector<int>> mRefs;
+        std::vector<std::vector<int>> mByRefs; // Неизвестные символы по числу ссылок.
+        std::vector<int> mBucketPos;           // Позиция символа в его корзине.
+        int mMaxRefs = 0;
+        std::vector<Equation> mEquations;
+        std::vector<int> mRipple;
+        std::vector<int> mInactive;
+        std::unordered_map<int, int> mInactiveIndex;
+        int mUnresolved;
+        bool mIsComplete = false;
+    };
+
+} // namespace fountain
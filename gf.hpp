@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <map>
 #include <vector>
+#include <array>
 
 namespace gf {
 
@@ -129,6 +130,82 @@ private:
    std::size_t FillLut( const State& g_poly );
 };
 
+/**
+ * Быстрая табличная арифметика поля GF(2^q). Элементы - в векторной форме (биты полинома),
+ * сложение - побитовый XOR, умножение - через таблицы логарифмов и степеней.
+ */
+template< int q >
+class FastGF2
+{
+public:
+   static constexpr int Order = 1 << q;
+   static constexpr int N = Order - 1;
+
+   explicit FastGF2( const GFLUT& lut )
+   {
+      for( const auto& [ idx, state ] : lut.OrderedLut() )
+      {
+         int vec = 0;
+         for( int k = 0; k < q; ++k )
+            vec |= ( state.mState.at( k ) & 1 ) << k;
+         if( idx >= 0 )
+         {
+            mExp[ idx ] = vec;
+            mExp[ idx + N ] = vec;
+         }
+         mLog[ vec ] = idx;
+      }
+   }
+
+   static int Add( int a, int b )
+   {
+      return a ^ b;
+   }
+
+   int Mult( int a, int b ) const
+   {
+      return ( a == 0 || b == 0 ) ? 0 : mExp[ mLog[ a ] + mLog[ b ] ];
+   }
+
+   int Inv( int a ) const
+   {
+      return mExp[ ( N - mLog[ a ] ) % N ];
+   }
+
+   /**
+    * Элемент "альфа" в степени idx (idx >= 0).
+    */
+   int Exp( int idx ) const
+   {
+      return mExp[ idx % N ];
+   }
+
+   /**
+    * Индекс элемента; для нуля -1.
+    */
+   int Log( int a ) const
+   {
+      return mLog[ a ];
+   }
+
+   /**
+    * Перевод из представления "индекс + 1" (как в кодовых словах РС) в векторную форму и обратно.
+    */
+   int FromValue( int value ) const
+   {
+      return value == 0 ? 0 : mExp[ value - 1 ];
+   }
+
+   int ToValue( int vec ) const
+   {
+      return mLog[ vec ] + 1;
+   }
+
+private:
+   std::array< int, 2 * N > mExp{};
+   std::array< int, Order > mLog{};
+};
+
 /**
  * Класс для арифметических манипуляций с полем Галуа GF(p^q).
  */
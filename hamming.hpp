@@ -11,6 +11,12 @@
  #include <array>    // std::array
  #include <vector>   // std::vector
  #include <string>   // std::string
+ #include <span>     // std::span
+ #include <bit>      // std::countr_zero
+ #include <algorithm>  // std::binary_search, std::any_of, std::stable_sort, std::find
+ #include <functional> // std::function
+ #include <cstdint>    // uint64_t
+ #include "xor_kernel.hpp"
  
  namespace hamming
  {
@@ -82,6 +88,22 @@
       return { SymbolStatus::Uninitialized, {} }; 
     }
  
+    /**
+     * Сложение на месте, по смыслу совпадает с operator+, но без копирования символа.
+     */
+    CodeElement& operator+=( const CodeElement& other )
+    {
+       if( ( mStatus == SymbolStatus::Normal ) && ( other.mStatus == SymbolStatus::Normal ) )
+          XorInto( mSymbol, other.mSymbol );
+       else if( ( mStatus == SymbolStatus::Erased ) && ( other.mStatus == SymbolStatus::Normal ) )
+          *this = other;
+       else if( ( mStatus == SymbolStatus::Erased ) && ( other.mStatus == SymbolStatus::Erased ) )
+          mSymbol = {};
+       else if( ( mStatus != SymbolStatus::Normal ) || ( other.mStatus != SymbolStatus::Erased ) )
+          *this = { SymbolStatus::Uninitialized, {} }; // Нормальный + стертый - без изменений.
+       return *this;
+    }
+
     /**
      * 
      */
@@ -262,7 +284,7 @@
       if (where_unit == -1)
          continue;
       if (where_unit > k) {
-         free_column[ k ] = free_column.at(k) + free_column.at( where_unit );
+         free_column[ k ] += free_column.at( where_unit );
          for( int k1 = 0; k1 < erased; ++k1 ) {
             selected[k][k1] ^= selected.at( where_unit ).at( k1 );
          }
@@ -274,7 +296,7 @@
       for( int i = k + 1; i < R; ++i ) {
          const bool is_not_zero = (selected.at(i).at(k) != 0);
          if (is_not_zero) {
-            free_column[ i ] = free_column.at(i) + free_column.at( k );
+            free_column[ i ] += free_column.at( k );
             for( int k1 = 0; k1 < erased; ++k1 ) {
                selected[i][k1] ^= selected.at( k ).at( k1 );
             }
@@ -283,6 +305,101 @@
    }
  }
 
+ /**
+  * Метод Гаусса "четырех русских" (M4RI) с тем же результатом для обратного хода, что и Gauss, но с полным
+  * приведением: ведущий элемент столбца k - в строке k, прочие элементы столбцов с ведущим элементом нулевые.
+  * Строки матрицы упакованы в 64-битные слова; столбцы обрабатываются блоками по kBlockBits, для блока
+  * строится таблица всех сумм его ведущих строк (вместе со свободными членами, одно сложение на элемент),
+  * и каждая остальная строка очищается одним сложением с элементом таблицы.
+  * Сложность O(r * e^2 / (64 * kBlockBits)) операций над словами и O(r * e / kBlockBits) сложений символов.
+  */
+ template< typename T, int M >
+ void GaussM4RI(CodeWord<T, M>& free_column, Matrix<int>& selected) {
+   static constexpr int kBlockBits = 8;
+   const int R = free_column.size();
+   assert(R > 0);
+   assert(!selected.empty());
+   const int erased = selected.at(0).size();
+   assert(erased > 0);
+   const int words = (erased + 63) / 64;
+   using Row = std::vector<uint64_t>;
+   std::vector<Row> rows(R, Row(words, 0));
+   for (int i = 0; i < R; ++i) {
+      for (int j = 0; j < erased; ++j) {
+         if (selected[i][j] != 0)
+            rows[i][j / 64] |= uint64_t(1) << (j % 64);
+      }
+   }
+   auto bit = [](const Row& row, int j) -> bool { return (row[j / 64] >> (j % 64)) & 1; };
+   auto add_row = [&](int dst, int src) {
+      for (int w = 0; w < words; ++w)
+         rows[dst][w] ^= rows[src][w];
+      free_column[dst] += free_column[src];
+   };
+   std::vector<Row> table_rows(1 << kBlockBits, Row(words, 0));
+   CodeWord<T, M> table_rhs(1 << kBlockBits);
+   std::vector<int> pivots;
+   for (int c = 0; c < erased; c += kBlockBits) {
+      const int block = std::min(kBlockBits, erased - c);
+      // Ведущие строки блока (столбец c + t - в строке c + t), приведенные друг относительно друга.
+      pivots.clear();
+      for (int t = 0; t < block; ++t) {
+         const int col = c + t;
+         int where_unit = -1;
+         for (int i = col; i < R && where_unit == -1; ++i) {
+            for (const int p : pivots) {
+               if (bit(rows[i], p))
+                  add_row(i, p);
+            }
+            if (bit(rows[i], col))
+               where_unit = i;
+         }
+         if (where_unit == -1)
+            continue;
+         if (where_unit != col) {
+            std::swap(rows[where_unit], rows[col]);
+            std::swap(free_column[where_unit], free_column[col]);
+         }
+         for (const int p : pivots) {
+            if (bit(rows[p], col))
+               add_row(p, col);
+         }
+         pivots.push_back(col);
+      }
+      if (pivots.empty())
+         continue;
+      // Таблица сумм ведущих строк: элемент с номером m - сумма строк pivots[t] для единичных битов t числа m.
+      const int size = 1 << pivots.size();
+      std::fill(table_rows[0].begin(), table_rows[0].end(), 0);
+      table_rhs[0] = CodeElement<T, M>{ .mStatus = SymbolStatus::Normal, .mSymbol = {} };
+      for (int g = 1; g < size; ++g) {
+         const int t = std::countr_zero(unsigned(g));
+         const int prev = g & (g - 1);
+         const int src = pivots[t];
+         for (int w = 0; w < words; ++w)
+            table_rows[g][w] = table_rows[prev][w] ^ rows[src][w];
+         table_rhs[g] = table_rhs[prev];
+         table_rhs[g] += free_column[src];
+      }
+      for (int i = 0; i < R; ++i) {
+         if (std::find(pivots.begin(), pivots.end(), i) != pivots.end())
+            continue; // Ведущая строка блока.
+         int m = 0;
+         for (int t = 0; t < int(pivots.size()); ++t)
+            m |= int(bit(rows[i], pivots[t])) << t;
+         if (m == 0)
+            continue;
+         for (int w = 0; w < words; ++w)
+            rows[i][w] ^= table_rows[m][w];
+         free_column[i] += table_rhs[m];
+      }
+   }
+   for (int i = 0; i < R; ++i) {
+      for (int j = 0; j < erased; ++j)
+         selected[i][j] = bit(rows[i], j);
+   }
+ }
+
  template <typename T>
  inline constexpr T power2( int x )
  {
@@ -348,6 +465,31 @@
       std::tie(mHsys, mSwaps) = MakeParityMatrixSystematic( mH, is_ok );
       // show_matrix(mHsys, "Systematic:");
       assert(is_ok);
+      // Позиции символов в принятом векторе несистематического кода: Decode применяет
+      // перестановки mSwaps к принятому вектору, после чего информационные символы - первые K.
+      mPositionsSys.resize(N);
+      for (int i = 0; i < N; ++i)
+         mPositionsSys[i] = i;
+      mPositionsNonSys = mPositionsSys;
+      for (const auto& [a, b] : mSwaps)
+         std::swap(mPositionsNonSys[a], mPositionsNonSys[b]);
+      BuildFastPaths();
+    }
+
+    /**
+     * Позиции символов в принятом векторе (с учетом режима кодирования): символ i систематического
+     * кодового слова (столбец i матрицы mHsys) принят на позиции ReceivedPositions()[i].
+     */
+    const std::vector<int>& ReceivedPositions() const {
+       return mIsSystematic ? mPositionsSys : mPositionsNonSys;
+    }
+
+    /**
+     * Позиции K информационных символов в принятом векторе:
+     * информационный символ k после Decode равен принятому символу на позиции InformationPositions()[k].
+     */
+    std::span<const int> InformationPositions() const {
+       return std::span<const int>(ReceivedPositions()).first(K);
     }
  
     /**
@@ -368,7 +510,7 @@
           {
              if( mHsys.at( i ).at( k ) == 0 )
                 continue;
-             element = element + a.at( k );
+             element += a.at( k );
           }
           result.push_back( element );
        }
@@ -393,7 +535,7 @@
           for( int k = 0; k < N; ++k ) {
              if (parity_check.at(i).at(k) == 0)
                 continue;
-             element = element + v.at( k );
+             element += v.at( k );
           }
           result.push_back( element );
        }
@@ -412,44 +554,56 @@
           }
        }
        const auto& parity_check = mHsys;
-       // Определяем индексы стертых символов и формируем столбец свободных членов.
-       std::vector< int > ids;
-       mFreeColumn.clear();
-       for (int j = 0; j < R; ++j) {
-         mFreeColumn.push_back(CodeElement<T, M>{.mStatus = hamming::SymbolStatus::Normal, .mSymbol = {}});
-       }
+       // Определяем индексы стертых символов.
+       auto& ids = mErasedIds;
+       ids.clear();
        for( int i = 0; i < N; ++i )
        {
-         if( v.at( i ).mStatus == SymbolStatus::Erased ) {
+         if( v.at( i ).mStatus == SymbolStatus::Erased )
             ids.push_back( i );
-         } else {
+       }
+       erased = ids.size();
+       if (erased > R) {
+         return false;
+       }
+       mIsSolved = true;
+       // Быстрые пути: стираний нет, одно или два стирания (предвычисленные проверочные уравнения).
+       if (erased == 0 || (erased == 1 && SolveSingle(v, ids[0])) || (erased == 2 && SolvePair(v, ids[0], ids[1]))) {
+          v.resize(K);
+          return true;
+       }
+       // Формируем столбец свободных членов. Буферы-члены переиспользуются: после первого вызова
+       // общий путь не выделяет память (кроме GaussM4RI при erased >= mBlockedGaussThreshold).
+       mFreeColumn.assign(R, CodeElement<T, M>{.mStatus = hamming::SymbolStatus::Normal, .mSymbol = {}});
+       for( int i = 0; i < N; ++i )
+       {
+         if( v.at( i ).mStatus != SymbolStatus::Erased ) {
             for( int j = 0; j < R; ++j )
             {
                if (parity_check.at(j).at(i))
-                  mFreeColumn[j] = mFreeColumn.at(j) + v.at(i);
+                  mFreeColumn[j] += v.at(i);
             }
          }
        }
-       erased = ids.size();
-       if (erased > R) {
-         return false;
-       }
        // Выбираем часть проверочной матрицы - подматрицу.
-       auto select_erasure_submatrix = [this, &parity_check](std::vector< int >& ids) {
-          mErasureSubmatrix.clear();
+       auto select_erasure_submatrix = [this, &parity_check](const std::vector< int >& ids) {
+          mErasureSubmatrix.resize(R);
           const int erased = ids.size();
          for( int j = 0; j < R; ++j )
          {
-            mErasureSubmatrix.emplace_back( erased, 0 );
+            mErasureSubmatrix[ j ].assign( erased, 0 );
             for( int i = 0; auto idx : ids )
                mErasureSubmatrix[ j ][ i++ ] = parity_check.at( j ).at( idx );
          }
        };
        select_erasure_submatrix(ids);
-      auto free_column = mFreeColumn;
+      auto& free_column = mFreeColumn;
       // show_codeword(free_column, -1, "free column:");
       // show_matrix(mErasureSubmatrix, "Erasure matrix:");
-      Gauss(free_column, mErasureSubmatrix);
+      if (erased >= mBlockedGaussThreshold)
+         GaussM4RI(free_column, mErasureSubmatrix);
+      else
+         Gauss(free_column, mErasureSubmatrix);
       // show_codeword(free_column, -1, "free column after Gauss method:");
       // show_matrix(mErasureSubmatrix, "Erasure matrix after Gauss method:");
       // Восстанавливаем стертые символы: решение СЛАУ обратным ходом.
@@ -459,10 +613,12 @@
          if (mErasureSubmatrix.at(k).at(k) != 0) {
             v[ idx_v ] = free_column.at(k);
             // std::cout << " v = " << std::endl;
+         } else {
+            mIsSolved = false;
          }
          for (int j = 0; j < erased - 1 - k; j++) {
             if (mErasureSubmatrix.at(k).at(k + j + 1) != 0) {
-               v[idx_v] = v.at(idx_v) + v.at(ids.at(k + j + 1));
+               v[idx_v] += v.at(ids.at(k + j + 1));
                // std::cout << " v += " << std::endl;
             }
          }
@@ -472,6 +628,183 @@
        return true;
     }
 
+    /**
+     * Восстановить единственный стертый символ e по предвычисленному уравнению наименьшего веса.
+     */
+    bool SolveSingle( CodeWord< T, M >& v, int e ) const
+    {
+       if (mSingleCover.empty() || mSingleCover[e] < 0)
+          return false;
+       v[e] = SumExcept(mDualSupports[mSingleCover[e]], v, e);
+       return true;
+    }
+
+    /**
+     * Восстановить два стертых символа e1, e2: первый - по уравнению без e2, второй - по уравнению без e1
+     * (либо с уже восстановленным e1).
+     */
+    bool SolvePair( CodeWord< T, M >& v, int e1, int e2 ) const
+    {
+       if (mPairCover.empty())
+          return false;
+       const int first = mPairCover[e1 * N + e2];
+       const int second = mPairCover[e2 * N + e1];
+       if (first < 0 || second < 0)
+          return false;
+       v[e1] = SumExcept(mDualSupports[first], v, e1);
+       v[e2] = SumExcept(mDualSupports[second], v, e2);
+       return true;
+    }
+
+    /**
+     * Сумма символов v на носителе support, кроме символа e.
+     */
+    static CodeElement< T, M > SumExcept( const std::vector<int>& support, const CodeWord< T, M >& v, int e )
+    {
+       CodeElement< T, M > sum{ .mStatus = SymbolStatus::Normal, .mSymbol = {} };
+       for (const int i : support) {
+          if (i != e)
+             sum += v[i];
+       }
+       return sum;
+    }
+
+    /**
+     * Предвычислить уравнения быстрых путей: для каждого символа - уравнение наименьшего веса,
+     * содержащее его; для каждой пары (e1, e2) - уравнение наименьшего веса, содержащее e1, но не e2.
+     */
+    void BuildFastPaths()
+    {
+       const auto& supports = DualSupports();
+       mSingleCover.assign(N, -1);
+       if (N <= 256)
+          mPairCover.assign(N * N, -1);
+       std::vector<bool> in_support(N);
+       for (int s = 0; s < int(supports.size()); ++s) {
+          std::fill(in_support.begin(), in_support.end(), false);
+          for (const int i : supports[s])
+             in_support[i] = true;
+          for (const int e1 : supports[s]) {
+             if (mSingleCover[e1] < 0)
+                mSingleCover[e1] = s;
+             if (mPairCover.empty())
+                continue;
+             for (int e2 = 0; e2 < N; ++e2) {
+                if (!in_support[e2] && mPairCover[e1 * N + e2] < 0)
+                   mPairCover[e1 * N + e2] = s;
+             }
+          }
+       }
+    }
+
+    /**
+     * Функция доступа к принятому символу по его позиции в принятом векторе.
+     * Недоступный (потерянный, неисправимый) символ возвращается со статусом Erased.
+     */
+    using Fetch = std::function<CodeElement<T, M>(int position)>;
+
+    /**
+     * Частичное декодирование: восстановить только информационные символы с номерами wanted.
+     * Принятые символы запрашиваются через fetch по мере необходимости, каждый - не более одного раза.
+     * Стертый нужный символ восстанавливается по проверочному уравнению наименьшего веса
+     * (кодовому слову дуального кода), все остальные символы которого доступны; если такого нет -
+     * запрашиваются все символы и выполняется полное декодирование.
+     * @param result Восстановленные символы в порядке wanted.
+     * @return Количество запрошенных символов или -1, если восстановить не удалось.
+     */
+    int DecodeSelected(const std::vector<int>& wanted, const Fetch& fetch, CodeWord<T, M>& result)
+    {
+       const auto& positions = ReceivedPositions();
+       const auto& supports = DualSupports();
+       CodeWord<T, M> known(N);
+       std::vector<bool> is_fetched(N, false);
+       int fetched = 0;
+       auto get = [&](int i) -> const CodeElement<T, M>& {
+          if (!is_fetched[i]) {
+             known[i] = fetch(positions[i]);
+             is_fetched[i] = true;
+             fetched++;
+          }
+          return known[i];
+       };
+       auto is_erased = [&](int i) {
+          return is_fetched[i] && known[i].mStatus == SymbolStatus::Erased;
+       };
+       result.clear();
+       for (const int k : wanted) {
+          assert(k >= 0 && k < K);
+          if (get(k).mStatus != SymbolStatus::Erased) {
+             result.push_back(known[k]);
+             continue;
+          }
+          bool is_recovered = false;
+          for (const auto& support : supports) {
+             if (!std::binary_search(support.begin(), support.end(), k))
+                continue;
+             if (std::any_of(support.begin(), support.end(), [&](int i) { return i != k && is_erased(i); }))
+                continue;
+             CodeElement<T, M> sum{ .mStatus = SymbolStatus::Normal, .mSymbol = {} };
+             bool is_ok = true;
+             for (const int i : support) {
+                if (i == k)
+                   continue;
+                if (get(i).mStatus == SymbolStatus::Erased) {
+                   is_ok = false;
+                   break;
+                }
+                sum += known[i];
+             }
+             if (is_ok) {
+                known[k] = sum;
+                is_recovered = true;
+                break;
+             }
+          }
+          if (!is_recovered) {
+             // Ни одно уравнение не подошло: полное декодирование.
+             CodeWord<T, M> v(N);
+             for (int i = 0; i < N; ++i)
+                v[positions[i]] = get(i);
+             int erased;
+             if (!Decode(v, erased) || !mIsSolved)
+                return -1;
+             for (int i = 0; i < K; ++i)
+                known[i] = v[i];
+          }
+          result.push_back(known[k]);
+       }
+       return fetched;
+    }
+
+    /**
+     * Носители кодовых слов дуального кода по возрастанию веса. При R > 12 - только строки mHsys.
+     */
+    const Matrix<int>& DualSupports()
+    {
+       if (!mDualSupports.empty())
+          return mDualSupports;
+       const int combinations = R <= 12 ? (1 << R) : R + 1;
+       std::vector<int> row(N, 0);
+       for (int c = 1; c < combinations; ++c) {
+          if (R <= 12) {
+             // Код Грея: соседние комбинации отличаются одной строкой.
+             const int bit = std::countr_zero(unsigned(c));
+             for (int i = 0; i < N; ++i)
+                row[i] ^= mHsys.at(bit).at(i);
+          } else {
+             row = mHsys.at(c - 1);
+          }
+          auto& support = mDualSupports.emplace_back();
+          for (int i = 0; i < N; ++i) {
+             if (row[i] != 0)
+                support.push_back(i);
+          }
+       }
+       std::stable_sort(mDualSupports.begin(), mDualSupports.end(),
+                        [](const auto& x, const auto& y) { return x.size() < y.size(); });
+       return mDualSupports;
+    }
+
     /**
      * 
      */
@@ -493,6 +826,40 @@
      */
     Swaps< int > mSwaps;
  
+    /**
+     * Позиции символов в принятом векторе для систематического и несистематического режимов.
+     */
+    std::vector<int> mPositionsSys;
+    std::vector<int> mPositionsNonSys;
+
+    /**
+     * Носители ненулевых кодовых слов дуального кода (сумм строк mHsys) по возрастанию веса.
+     */
+    Matrix<int> mDualSupports;
+
+    /**
+     * Быстрые пути декодирования: номер уравнения (в mDualSupports) для одного стирания
+     * и для пары стираний (индекс e1 * N + e2); -1 - уравнения нет.
+     */
+    std::vector<int> mSingleCover;
+    std::vector<int> mPairCover;
+
+    /**
+     * Признак того, что последнее декодирование восстановило все стертые символы
+     * (подматрица стираний имела полный ранг).
+     */
+    bool mIsSolved = true;
+
+    /**
+     * Количество стираний, начиная с которого используется блочный метод Гаусса (GaussM4RI).
+     */
+    int mBlockedGaussThreshold = 32;
+
+    /**
+     * Индексы стертых символов последнего декодирования.
+     */
+    std::vector<int> mErasedIds;
+ 
     /**
      * Проверочная матрица кода (несистематическая).
      */
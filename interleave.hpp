@@ -0,0 +1,174 @@
+/**
+ * Перемежение между внутренним и внешним кодом: пакет ошибок канала (замирание) распределяется
+ * по многим кодовым словам РС и блокам, так что каждое слово получает не больше ошибок,
+ * чем исправляет код РС, и внешний код не теряет несколько символов одного блока сразу.
+ */
+
+#pragma once
+
+#include <cstdint>   // uint8_t
+#include <cstddef>   // std::size_t
+#include <algorithm> // std::min
+#include <vector>    // std::vector
+#include <utility>   // std::swap
+#include "rsexh.hpp"
+
+namespace interleave {
+
+    /**
+     * Сторона плитки транспонирования: плитка 32 x 32 помещается в L1 и для источника, и для приемника.
+     */
+    inline constexpr int kTile = 32;
+
+    /**
+     * Транспонирование матрицы rows x cols плитками: put(c, r, get(r, c)).
+     * Обход одной плиткой за раз держит в кеше и строки источника, и строки приемника,
+     * поэтому перестановка выполняется за один проход без промежуточного буфера.
+     */
+    template <typename Get, typename Put>
+    inline void TransposeTiled(int rows, int cols, Get&& get, Put&& put)
+    {
+        for (int r0 = 0; r0 < rows; r0 += kTile) {
+            const int r1 = std::min(r0 + kTile, rows);
+            for (int c0 = 0; c0 < cols; c0 += kTile) {
+                const int c1 = std::min(c0 + kTile, cols);
+                for (int c = c0; c < c1; ++c) {
+                    for (int r = r0; r < r1; ++r)
+                        put(c, r, get(r, c));
+                }
+            }
+        }
+    }
+
+    /**
+     * Блочный перемежитель глубины depth. Суперкадр - depth блоков каскадного кода, то есть
+     * depth * N слов РС по n полубайт (строки матрицы, слова блока 0, затем блока 1, ...).
+     * В канал полубайты идут по столбцам: полубайт 0 всех слов, полубайт 1 всех слов, ...
+     * Пакет из L полубайт вносит в каждое слово не более ceil(L / (depth * N)) ошибок.
+     */
+    class BlockInterleaver
+    {
+    public:
+        /**
+         * @param depth Количество блоков в суперкадре (1 - перемежение только внутри блока).
+         * @param words Количество слов РС в блоке (длина внешнего кода).
+         */
+        BlockInterleaver(int depth, int words) : mDepth{depth}, mWords{words}
+        {
+            assert(depth >= 1);
+        }
+
+        int Depth() const { return mDepth; }
+
+        /**
+         * Количество полубайт суперкадра из blocks блоков (последний суперкадр потока может быть неполным).
+         */
+        std::size_t Nibbles(int blocks) const
+        {
+            return std::size_t(blocks) * mWords * rsexh::RsExh::N;
+        }
+
+        /**
+         * Перемежить blocks блоков (не больше depth): put(position, nibble) для каждого полубайта суперкадра.
+         */
+        template <typename Put>
+        void Interleave(const rsexh::Matrix<int>* v, int blocks, Put&& put) const
+        {
+            const int rows = blocks * mWords;
+            TransposeTiled(rows, rsexh::RsExh::N,
+                [this, v](int r, int t) { return v[r / mWords][r % mWords][t]; },
+                [rows, &put](int t, int r, int nibble) { put(std::size_t(t) * rows + r, nibble); });
+        }
+
+        /**
+         * Обратное перемежение. get(position) возвращает полубайт канала; позиции начиная с available
+         * не приняты (обрезанный поток). Слово, потерявшее больше полубайт, чем исправляет код РС,
+         * остается пустым - стертым; остальные непринятые полубайты заменяются нулями (ошибками).
+         */
+        template <typename Get>
+        void Deinterleave(Get&& get, std::size_t available, rsexh::Matrix<int>* v, int blocks) const
+        {
+            constexpr int n = rsexh::RsExh::N;
+            const int rows = blocks * mWords;
+            for (int b = 0; b < blocks; ++b) {
+                v[b].resize(mWords);
+                for (auto& word : v[b])
+                    word.resize(n);
+            }
+            TransposeTiled(n, rows,
+                [rows, available, &get](int t, int r) {
+                    const std::size_t position = std::size_t(t) * rows + r;
+                    return position < available ? get(position) : 0;
+                },
+                [this, v](int r, int t, int nibble) { v[r / mWords][r % mWords][t] = nibble; });
+            // Полубайт t слова r принят, если t * rows + r < available.
+            for (int r = 0; r < rows; ++r) {
+                int missing = 0;
+                for (int t = n - 1; t >= 0 && std::size_t(t) * rows + r >= available; --t)
+                    missing++;
+                if (missing > 2)
+                    v[r / mWords][r % mWords].clear();
+            }
+        }
+
+    private:
+        int mDepth;
+        int mWords;
+    };
+
+    /**
+     * Сверточный перемежитель (Форни): символ i попадает в ветвь i mod branches с задержкой
+     * (номер ветви) * delay символов этой ветви; у обратного перемежителя задержки дополняющие.
+     * Задержка пары перемежитель + обратный - branches * (branches - 1) * delay символов,
+     * память - вдвое меньше, чем у блочного перемежителя с тем же разнесением.
+     */
+    template <typename T>
+    class ConvolutionalInterleaver
+    {
+    public:
+        ConvolutionalInterleaver(int branches, int delay, bool is_inverse)
+            : mLength(branches), mOffset(branches), mHead(branches, 0)
+        {
+            std::size_t total = 0;
+            for (int j = 0; j < branches; ++j) {
+                mLength[j] = (is_inverse ? branches - 1 - j : j) * delay;
+                mOffset[j] = total;
+                total += mLength[j];
+            }
+            mLines.assign(total, T{});
+        }
+
+        /**
+         * Полная задержка пары перемежитель + обратный перемежитель, символов.
+         */
+        static std::size_t Latency(int branches, int delay)
+        {
+            return std::size_t(branches) * (branches - 1) * delay;
+        }
+
+        /**
+         * Пропустить символы через перемежитель на месте.
+         */
+        void Process(T* data, std::size_t count)
+        {
+            const int branches = mLength.size();
+            for (std::size_t i = 0; i < count; ++i) {
+                const int j = mBranch;
+                mBranch = (mBranch + 1 == branches) ? 0 : mBranch + 1;
+                if (mLength[j] == 0)
+                    continue;
+                T& cell = mLines[mOffset[j] + mHead[j]];
+                std::swap(cell, data[i]);
+                mHead[j] = (mHead[j] + 1 == mLength[j]) ? 0 : mHead[j] + 1;
+            }
+        }
+
+    private:
+        std::vector<int> mLength;
+        std::vector<std::size_t> mOffset;
+        std::vector<int> mHead;
+        std::vector<T> mLines;
+        int mBranch = 0;
+    };
+
+} // namespace interleave
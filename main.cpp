@@ -2,7 +2,28 @@
 #include <random>
 #include <cassert>
 #include <set>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <bit>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
 #include "rsexh.hpp"
+#include "stream.hpp"
+#include "parity.hpp"
+#include "packet_fec.hpp"
+#include "sliding.hpp"
+#include "fountain.hpp"
+#include "static_hamming.hpp"
+#include "policy.hpp"
+#include "interleave.hpp"
+#include "channel.hpp"
+#include "sim.hpp"
+#include "sweep.hpp"
+#include "analysis.hpp"
+#include "verify.hpp"
+#include "telemetry.hpp"
 
 static auto const seed = std::random_device{}();
 
@@ -20,12 +41,28 @@ auto roll_error = [urbg = std::mt19937{seed},
    return error_probability == 0 ? false : distr(urbg) <= threshold;
 };
 
+/***
+ * Прочитать файл целиком.
+ */
+std::vector<uint8_t> read_file(const std::string& path) {
+   std::ifstream in{path, std::ios::binary};
+   return std::vector<uint8_t>{std::istreambuf_iterator<char>{in}, {}};
+}
+
+/***
+ * Записать файл целиком.
+ */
+void write_file(const std::string& path, const std::vector<uint8_t>& bytes) {
+   std::ofstream out{path, std::ios::binary};
+   out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
 void test_ex_hamming_code(bool is_systematic) {
    std::cout << "Test Extended Hamming (default) code: " << (is_systematic ? "systematic" : "nonsystematic") << std::endl;;
    static constexpr int R2 = 6;  // Количество проверочных символов внешнего кода.
    static constexpr int M2 = 9;  // Количество внутренних символов внешнего кода.
    static hamming::HammingExtended< int, R2, M2 > mHammingCode;
-   std::vector<std::set<int>> test_erasures = {{2, 5, 20}, {3, 7, 17}, {2, 3, 14}, {11, 14}, {1, 2, 9, 12}};
+   std::vector<std::set<int>> test_erasures = {{2, 5, 20}, {3, 7, 17}, {2, 3, 14}, {11, 14}, {1, 2, 9, 12}, {}, {6}, {30}, {0, 31}, {25, 4}};
    mHammingCode.SwitchToSystematic(is_systematic);
    hamming::CodeWord<int, M2> a(mHammingCode.K);
    for (int erasure_round = 0; const auto& erasures : test_erasures) {
@@ -74,23 +111,11 @@ void test_golay_code(bool is_systematic) {
    std::cout << "Test Golay code: " << (is_systematic ? "systematic" : "nonsystematic") << std::endl;
    static constexpr int R2 = 11; // Количество проверочных символов внешнего кода.
    static constexpr int M2 = 9;  // Количество внутренних символов внешнего кода.
-   static hamming::HammingExtended< int, R2, M2 > mHammingCode{
-      rsexh::Matrix<int>{ // Код Голея, циклический. Кодовое расстояние - 7.
-            {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1}, 
-            {0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0}, 
-            {0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0}, 
-            {0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0}, 
-            {0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0}, 
-            {0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}, 
-            {0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0}, 
-            {0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, 
-            {0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0}, 
-            {0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 
-            {1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
-      }, 7
-   };
+   // Код Голея, циклический. Кодовое расстояние - 7.
+   static hamming::HammingExtended< int, R2, M2 > mHammingCode{hamming::ToMatrix(hamming::kGolayParityMatrix), 7};
    std::vector<std::set<int>> test_erasures = {{2, 5, 20}, {1, 6, 9, 12}, {3, 7, 17}, {2, 3, 14}, {0, 4, 13, 15, 16}, 
-         {10, 11, 16, 17}, {4, 9, 10, 11, 14}, {0, 1, 6, 9, 11}, {0, 2, 5, 6, 8, 10}, {1, 3, 7, 19}, {0, 8, 9, 16, 21}};
+         {10, 11, 16, 17}, {4, 9, 10, 11, 14}, {0, 1, 6, 9, 11}, {0, 2, 5, 6, 8, 10}, {1, 3, 7, 19}, {0, 8, 9, 16, 21},
+         {}, {7}, {22}, {5, 18}, {12, 13}};
    mHammingCode.SwitchToSystematic(is_systematic);
    hamming::CodeWord<int, M2> a(mHammingCode.K);
    for (int erasure_round = 0; const auto& erasures : test_erasures) {
@@ -134,6 +159,1116 @@ void test_golay_code(bool is_systematic) {
    }
 }
 
+void test_packet_fec(double loss) {
+   std::cout << "Test packet FEC over lossy loopback, loss: " << loss << "... ";
+   static constexpr int R = 5;           // Восстанавливающих пакетов в поколении.
+   static constexpr int MaxPacket = 256; // Наибольшая длина пакета.
+   static constexpr int packets = 2000;
+   std::vector<std::vector<uint8_t>> sent;
+   std::vector<std::vector<uint8_t>> delivered(packets);
+   int deliveries = 0;
+   int phantoms = 0; // Доставки за пределами потока (несуществующие пакеты последнего неполного поколения).
+   fec::Decoder<R, MaxPacket> decoder{[&](uint32_t generation, int index, const uint8_t* data, int length) {
+      const std::size_t id = std::size_t(generation) * 11 + index; // K = 2^(R-1) - R = 11.
+      deliveries++;
+      if (id >= delivered.size()) {
+         phantoms++;
+         return;
+      }
+      delivered[id].assign(data, data + length);
+   }};
+   fec::LossyLoopback channel{loss, 12345, [&](const uint8_t* p, int n) { decoder.Receive(p, n); }};
+   fec::Encoder<R, MaxPacket> encoder{[&](const uint8_t* p, int n) { channel.Send(p, n); }};
+   assert(encoder.K() == 11);
+   for (int i = 0; i < packets; ++i) {
+      std::vector<uint8_t> packet(roll_uint() % (MaxPacket + 1));
+      for (auto& b : packet)
+         b = roll_uint();
+      encoder.Add(packet.data(), packet.size());
+      sent.push_back(std::move(packet));
+   }
+   encoder.Flush();
+   decoder.Flush();
+   int missing = 0;
+   int wrong = 0;
+   for (int i = 0; i < packets; ++i) {
+      if (!delivered[i].empty() && delivered[i] != sent[i])
+         wrong++;
+      missing += delivered[i].empty() && !sent[i].empty();
+   }
+   const auto& stats = decoder.Stats();
+   // Декодер, не восстанавливающий ничего, тоже не выдает ошибочных пакетов: восстановление проверяется отдельно.
+   // При 2% потерь поколение теряет больше R пакетов крайне редко, поэтому потерь быть не должно.
+   // packets не кратно K: последнее поколение неполное и не должно порождать лишних доставок.
+   static_assert(packets % 11 != 0);
+   const bool is_ok = wrong == 0 && phantoms == 0 && stats.mRecovered > 0 &&
+      (loss > 0.02 || (stats.mLost == 0 && missing == 0 && deliveries == packets));
+   std::cout << "dropped: " << channel.Dropped() << ", recovered: " << stats.mRecovered
+             << ", lost: " << stats.mLost << ", missing: " << missing << ", phantoms: " << phantoms
+             << ", wrong: " << wrong
+             << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_sliding_window(double loss, uint32_t first_seq = 0) {
+   std::cout << "Test sliding window code, loss: " << loss << ", first seq: " << first_seq << "... ";
+   static constexpr int M = 4;
+   const int window = 16;
+   const int interval = 4; // Избыточность 25%.
+   const int symbols = 5000;
+   std::vector<hamming::CodeElement<int, M>> sent;
+   int wrong = 0;
+   sliding::Decoder<int, M> decoder{window, 2 * window, [&](uint32_t seq, const hamming::CodeElement<int, M>* el) {
+      if (el && !(*el == sent.at(seq - first_seq)))
+         wrong++;
+   }, first_seq};
+   std::mt19937 channel{777};
+   std::uniform_real_distribution<double> distr{0., 1.};
+   sliding::Encoder<int, M> encoder{window, interval, [&](const sliding::Packet<int, M>& packet) {
+      if (distr(channel) >= loss)
+         decoder.Receive(packet);
+   }, first_seq};
+   for (int i = 0; i < symbols; ++i) {
+      hamming::CodeElement<int, M> el{hamming::SymbolStatus::Normal, {}};
+      for (auto& symbol : el.mSymbol)
+         symbol = roll_uint() & 15;
+      sent.push_back(el);
+      encoder.Add(el);
+   }
+   decoder.Flush();
+   const auto& stats = decoder.Stats();
+   std::cout << "recovered: " << stats.mRecovered << ", lost: " << stats.mLost
+             << ", mean delay: " << (1. * stats.mDelaySum) / std::max(1LL, stats.mDelivered)
+             << ", max delay: " << stats.mMaxDelay << ", wrong: " << wrong;
+   // Работающий декодер теряет меньше символов, чем канал, в том числе после переполнения номеров.
+   const bool is_ok = wrong == 0 && stats.mDelivered + stats.mLost == symbols && stats.mLost < loss * symbols;
+   std::cout << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_fountain(int K, double loss) {
+   std::cout << "Test fountain code, K: " << K << ", loss: " << loss << "... ";
+   static constexpr int M = 4;
+   hamming::CodeWord<int, M> source(K);
+   for (auto& el : source) {
+      el.mStatus = hamming::SymbolStatus::Normal;
+      for (auto& symbol : el.mSymbol)
+         symbol = roll_uint() & 15;
+   }
+   fountain::Encoder<int, M> encoder{hamming::CodeWord<int, M>(source)}; // Временный блок: кодер хранит копию.
+   fountain::Decoder<int, M> decoder{K};
+   std::mt19937 channel{4242};
+   std::uniform_real_distribution<double> distr{0., 1.};
+   int received = 0;
+   uint32_t id = 0;
+   for (; !decoder.IsComplete(); ++id) {
+      const auto symbol = encoder.Generate(id);
+      if (distr(channel) < loss)
+         continue;
+      received++;
+      decoder.Add(id, symbol);
+   }
+   const bool is_equal = decoder.Sources() == source;
+   std::cout << "sent: " << id << ", received: " << received << ", overhead: " << (1. * received) / K
+             << ", inactivated: " << decoder.Inactivated() << (is_equal ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_equal);
+}
+
+void test_partial_decode(int lost_words) {
+   std::cout << "Test partial decode, lost RS words: " << lost_words << "... ";
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   const int K = code.mHammingCode.K;
+   const int N = code.mHammingCode.N;
+   long long decoded_words = 0;
+   int reads = 0;
+   int failures = 0;
+   for (int round = 0; round < 200; ++round) {
+      hamming::CodeWord<int, code.M2> a(K);
+      for (auto& el : a) {
+         el.mStatus = hamming::SymbolStatus::Normal;
+         for (auto& symbol : el.mSymbol)
+            symbol = roll_uint() & 15;
+      }
+      std::vector<std::vector<int>> v;
+      code.EncodeBlock(a, v);
+      for (int i = 0; i < lost_words; ++i)
+         v[roll_uint() % N].clear();
+      const std::vector<int> wanted{int(roll_uint() % K)};
+      hamming::CodeWord<int, code.M2> a_selected;
+      const int words = code.DecodeSelected(v, wanted, a_selected);
+      if (words < 0) {
+         failures++;
+         continue;
+      }
+      reads++;
+      decoded_words += words;
+      assert(a_selected.size() == 1 && a_selected[0] == a.at(wanted[0]));
+   }
+   std::cout << "mean decoded words per read: " << (1. * decoded_words) / std::max(reads, 1)
+             << " of " << N << ", failures: " << failures << std::endl;
+   assert(lost_words >= code.mHammingCode.D || failures == 0);
+}
+
+void test_large_outer_code(int erasures) {
+   std::cout << "Test large outer code (576, 384), erasures: " << erasures << "... ";
+   static constexpr int R = 192;
+   static constexpr int M = 16;
+   const int N = 576;
+   hamming::Matrix<int> H(R, std::vector<int>(N));
+   for (auto& row : H) {
+      for (auto& el : row)
+         el = roll_uint() & 1;
+   }
+   hamming::HammingExtended<int, R, M> code{H, 3};
+   hamming::CodeWord<int, M> a(code.K);
+   for (auto& el : a) {
+      el.mStatus = hamming::SymbolStatus::Normal;
+      for (auto& symbol : el.mSymbol)
+         symbol = roll_uint() & 15;
+   }
+   auto v = code.Encode(a);
+   std::set<int> erased_ids;
+   while (int(erased_ids.size()) < erasures)
+      erased_ids.insert(roll_uint() % N);
+   for (const int i : erased_ids) {
+      v[i].mStatus = hamming::SymbolStatus::Erased;
+      v[i].mSymbol.fill(-1);
+   }
+   auto decode = [&](int threshold, double& ms) {
+      auto received = v;
+      code.mBlockedGaussThreshold = threshold;
+      int erased;
+      const auto start = std::chrono::steady_clock::now();
+      const bool is_ok = code.Decode(received, erased) && code.mIsSolved;
+      ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      return is_ok && received == a;
+   };
+   double ms_scalar, ms_blocked;
+   const bool is_ok_scalar = decode(N + 1, ms_scalar);
+   const bool is_ok_blocked = decode(1, ms_blocked);
+   std::cout << "Gauss: " << ms_scalar << " ms, M4RI: " << ms_blocked << " ms"
+             << ((is_ok_scalar && is_ok_blocked) ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok_scalar && is_ok_blocked);
+}
+
+void test_iterative_decode(double ber, int blocks) {
+   std::cout << "Test iterative decode, channel BER: " << ber << "... ";
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   const int K = code.mHammingCode.K;
+   int lost_one_shot = 0;
+   int lost_iterative = 0;
+   // Необнаруженные ошибки: декодер сообщил об успехе, но данные неверны.
+   int undetected_one_shot = 0;
+   int undetected_iterative = 0;
+   // Фиксированное зерно: строгие сравнения ниже не должны зависеть от запуска.
+   std::mt19937 urbg{2025};
+   std::bernoulli_distribution flip{ber};
+   for (int b = 0; b < blocks; ++b) {
+      hamming::CodeWord<int, code.M2> a(K);
+      for (auto& el : a) {
+         el.mStatus = hamming::SymbolStatus::Normal;
+         for (auto& symbol : el.mSymbol)
+            symbol = urbg() & 15;
+      }
+      std::vector<std::vector<int>> v;
+      code.EncodeBlock(a, v);
+      for (auto& word : v) {
+         for (auto& el : word) {
+            for (int i = 0; i < 4; ++i)
+               el ^= static_cast<int>(flip(urbg)) << i;
+         }
+      }
+      auto is_equal = [&](const hamming::CodeWord<int, code.M2>& decoded) {
+         return int(decoded.size()) >= K && std::equal(a.begin(), a.end(), decoded.begin());
+      };
+      auto v_one_shot = v;
+      hamming::CodeWord<int, code.M2> decoded;
+      int erased;
+      const bool is_ok_one_shot = code.DecodeBlock(v_one_shot, decoded, erased, false);
+      lost_one_shot += !is_equal(decoded);
+      undetected_one_shot += is_ok_one_shot && !is_equal(decoded);
+      const bool is_ok = code.DecodeBlockIterative(v, decoded, erased);
+      lost_iterative += !is_equal(decoded);
+      undetected_iterative += is_ok && !is_equal(decoded);
+   }
+   std::cout << "lost blocks: one-shot: " << lost_one_shot << ", iterative: " << lost_iterative
+             << ", undetected: one-shot: " << undetected_one_shot << ", iterative: " << undetected_iterative
+             << " of " << blocks << std::endl;
+   assert(lost_iterative < lost_one_shot);
+   // Списочное декодирование с выбором кандидатов внешним кодом спасает заметную долю потерянных блоков.
+   assert(ber < 0.02 || 3 * lost_iterative < 2 * lost_one_shot);
+   assert(undetected_iterative <= undetected_one_shot);
+   // При достаточном числе необнаруженных ошибок сверка с внешним кодом должна отсеять часть из них.
+   assert(undetected_one_shot < 10 || undetected_iterative < undetected_one_shot);
+}
+
+void test_miscorrection_detection(double ber, int blocks) {
+   std::cout << "Test miscorrection detection, channel BER: " << ber << "... ";
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   const int K = code.mHammingCode.K;
+   int undetected_plain = 0;
+   int undetected_verified = 0;
+   int lost_plain = 0;
+   int lost_verified = 0;
+   int miscorrections = 0;
+   int false_miscorrections = 0; // Слова, объявленные ложно исправленными, но исправленные верно.
+   int inconsistent = 0;
+   std::mt19937 urbg{2026}; // Фиксированное зерно, как в test_iterative_decode.
+   std::bernoulli_distribution flip{ber};
+   for (int b = 0; b < blocks; ++b) {
+      hamming::CodeWord<int, code.M2> a(K);
+      for (auto& el : a) {
+         el.mStatus = hamming::SymbolStatus::Normal;
+         for (auto& symbol : el.mSymbol)
+            symbol = urbg() & 15;
+      }
+      std::vector<std::vector<int>> v;
+      code.EncodeBlock(a, v);
+      for (auto& word : v) {
+         for (auto& el : word) {
+            for (int i = 0; i < 4; ++i)
+               el ^= static_cast<int>(flip(urbg)) << i;
+         }
+      }
+      auto is_equal = [&](const hamming::CodeWord<int, code.M2>& decoded) {
+         return int(decoded.size()) >= K && std::equal(a.begin(), a.end(), decoded.begin());
+      };
+      const auto received = v;
+      auto v_plain = v;
+      hamming::CodeWord<int, code.M2> decoded;
+      int erased;
+      // Необнаруженная ошибка: декодер сообщил об успехе, но данные неверны.
+      const bool is_ok_plain = code.DecodeBlock(v_plain, decoded, erased, false);
+      undetected_plain += is_ok_plain && !is_equal(decoded);
+      lost_plain += !(is_ok_plain && is_equal(decoded));
+      const bool is_ok_verified = code.DecodeBlockVerified(v, decoded, erased);
+      undetected_verified += is_ok_verified && !is_equal(decoded);
+      lost_verified += !(is_ok_verified && is_equal(decoded));
+      miscorrections += code.mLastMiscorrections;
+      inconsistent += code.mLastInconsistent;
+      // Сверка с истинными символами внешнего кода: стертое слово действительно было исправлено ложно.
+      const auto sent = code.mHammingCode.Encode(a);
+      for (std::size_t i = 0; i < received.size(); ++i) {
+         if (code.mLastStatus[i] != rsexh::InnerStatus::Miscorrected)
+            continue;
+         auto word = received[i];
+         hamming::CodeElement<int, code.M2> symbol;
+         code.DecodeSymbol(word, symbol, code.mMode, false);
+         false_miscorrections += symbol.mStatus == hamming::SymbolStatus::Normal && symbol == sent[i];
+      }
+   }
+   std::cout << "undetected block errors: plain: " << undetected_plain << ", verified: " << undetected_verified
+             << ", lost blocks: plain: " << lost_plain << ", verified: " << lost_verified
+             << ", detected miscorrections: " << miscorrections << " (false: " << false_miscorrections
+             << "), inconsistent blocks: " << inconsistent << " of " << blocks << std::endl;
+   assert(undetected_verified <= undetected_plain);
+   assert(ber > 0.015 || undetected_verified == 0);
+   // Обнаружение не должно терять блоки, которые восстанавливает обычное декодирование.
+   assert(lost_verified <= lost_plain + blocks / 200);
+   assert(false_miscorrections == 0);
+}
+
+void test_adaptive_policy() {
+   std::cout << "Test adaptive correction policy..." << std::endl;
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   const int K = code.mHammingCode.K;
+   policy::AdaptivePolicy adaptive{code.mHammingCode.N, code.mHammingCode.D};
+   // Чистые фазы - с запасом ниже порога режима стирания: при BER 1e-4 доля искаженных слов (~0.006) близка
+   // к доле (~0.007), при которой прогноз потери блока достигает mTargetLoss, и режим колеблется.
+   const std::pair<double, int> phases[] = {{2.e-5, 1500}, {0.004, 1500}, {0.012, 1500}, {2.e-5, 1500}};
+   for (const auto& [ber, blocks] : phases) {
+      int lost = 0;
+      int mode_blocks[3] = {};
+      for (int b = 0; b < blocks; ++b) {
+         hamming::CodeWord<int, code.M2> a(K);
+         for (auto& el : a) {
+            el.mStatus = hamming::SymbolStatus::Normal;
+            for (auto& symbol : el.mSymbol)
+               symbol = roll_uint() & 15;
+         }
+         std::vector<std::vector<int>> v;
+         code.EncodeBlock(a, v);
+         for (auto& word : v) {
+            for (auto& el : word) {
+               for (int i = 0; i < 4; ++i)
+                  el ^= static_cast<int>(roll_error(ber)) << i;
+            }
+         }
+         code.mMode = adaptive.Current();
+         mode_blocks[static_cast<int>(code.mMode)]++;
+         hamming::CodeWord<int, code.M2> decoded;
+         int erased;
+         const bool is_ok = code.DecodeBlockVerified(v, decoded, erased) && std::equal(a.begin(), a.end(), decoded.begin());
+         lost += !is_ok;
+         adaptive.Observe(code.mLastStatus, is_ok, code.mLastMiscorrections);
+      }
+      std::cout << " ... channel BER: " << ber << ", blocks in modes erasure-only/1-error/2-error: " << mode_blocks[0]
+                << "/" << mode_blocks[1] << "/" << mode_blocks[2] << ", lost: " << lost
+                << ", dirty words: " << adaptive.GetStats().mDirty << std::endl;
+   }
+   assert(adaptive.Current() == rsexh::CorrectionMode::ErasureOnly);
+}
+
+/**
+ * Приемник событий канала, считающий инвертированные биты и искаженные символы слов.
+ */
+struct CountingTarget : channel::WordsTarget {
+   explicit CountingTarget(rsexh::Matrix<int>& v) : channel::WordsTarget{v}, mWordErrors(v.size()) {}
+
+   long long mFlipped = 0;
+   std::vector<int> mWordErrors; // Искаженных символов в каждом слове.
+
+   void Flip(std::size_t i, int mask) {
+      channel::WordsTarget::Flip(i, mask);
+      mFlipped += std::popcount(unsigned(mask));
+      mWordErrors[i / rsexh::RsExh::N]++;
+   }
+};
+
+/**
+ * Потери блоков на канале с пакетами ошибок: depth = 0 - без перемежения (слова подряд),
+ * depth > 0 - блочный перемежитель, depth < 0 - сверточный перемежитель.
+ */
+int count_burst_losses(int depth, int groups) {
+   static rsexh::RsExh code;
+   const int K = code.mHammingCode.K;
+   const int N = code.mHammingCode.N;
+   constexpr int n = rsexh::RsExh::N;
+   const int blocks = std::max(depth, 1);
+   const interleave::BlockInterleaver interleaver{blocks, N};
+   // Ветви сверточного перемежителя - позиции слова РС, соседние символы канала разнесены на блок.
+   interleave::ConvolutionalInterleaver<uint8_t> conv{n, N, false};
+   interleave::ConvolutionalInterleaver<uint8_t> deconv{n, N, true};
+   const std::size_t latency = interleave::ConvolutionalInterleaver<uint8_t>::Latency(n, N);
+   // Пакеты ошибок средней длиной 96 бит (24 полубайта).
+   const channel::GilbertElliott bursts{5.e-5, 1. / 96, 0., 0.2};
+   channel::CounterRng rng{seed, uint64_t(depth + 8)};
+   std::vector<rsexh::Matrix<int>> group(blocks);
+   std::vector<hamming::CodeWord<int, code.M2>> sent;
+   std::vector<uint8_t> nibbles(interleaver.Nibbles(blocks));
+   int lost = 0;
+   for (int g = 0; g < groups; ++g) {
+      for (int b = 0; b < blocks; ++b) {
+         hamming::CodeWord<int, code.M2> a(K);
+         for (auto& el : a) {
+            el.mStatus = hamming::SymbolStatus::Normal;
+            for (auto& symbol : el.mSymbol)
+               symbol = roll_uint() & 15;
+         }
+         code.EncodeBlock(a, group[b]);
+         sent.push_back(std::move(a));
+      }
+      if (depth > 0) {
+         interleaver.Interleave(group.data(), blocks, [&](std::size_t p, int nibble) { nibbles[p] = nibble; });
+      } else {
+         for (int w = 0; w < N; ++w)
+            std::copy(group[0][w].begin(), group[0][w].end(), nibbles.begin() + w * n);
+         if (depth < 0)
+            conv.Process(nibbles.data(), nibbles.size());
+      }
+      channel::BufferTarget<uint8_t> target{nibbles.data()};
+      bursts.Apply(nibbles.size(), rng, target);
+      if (depth > 0) {
+         interleaver.Deinterleave([&](std::size_t p) { return nibbles[p]; }, nibbles.size(), group.data(), blocks);
+      } else {
+         if (depth < 0)
+            deconv.Process(nibbles.data(), nibbles.size());
+         for (int w = 0; w < N; ++w)
+            group[0][w].assign(nibbles.begin() + w * n, nibbles.begin() + (w + 1) * n);
+      }
+      // Сверточный перемежитель задерживает поток на целое число блоков: n * (n - 1) * N полубайт.
+      const int delay = depth < 0 ? int(latency / nibbles.size()) : 0;
+      for (int b = 0; b < blocks; ++b) {
+         const int index = g * blocks + b - delay;
+         if (index < 0)
+            continue;
+         hamming::CodeWord<int, code.M2> decoded;
+         int erased;
+         const bool is_ok = code.DecodeBlock(group[b], decoded, erased) &&
+                            std::equal(sent[index].begin(), sent[index].end(), decoded.begin());
+         lost += !is_ok;
+      }
+   }
+   return lost;
+}
+
+void test_burst_interleaving(int groups) {
+   std::cout << "Test interleaving on a burst channel, lost blocks: ";
+   const int lost_plain = count_burst_losses(0, groups * 4);
+   const int lost_block_1 = count_burst_losses(1, groups * 4);
+   const int lost_block_4 = count_burst_losses(4, groups);
+   const int lost_conv = count_burst_losses(-1, groups * 4);
+   std::cout << "none: " << lost_plain << ", block depth 1: " << lost_block_1 << ", block depth 4: " << lost_block_4
+             << ", convolutional: " << lost_conv << " of " << groups * 4 << std::endl;
+   assert(lost_block_4 <= lost_plain);
+}
+
+/**
+ * Кодирование и декодирование потока через временные файлы; канал инвертирует случайные биты закодированного
+ * потока и, если dropped_frame >= 0, выбрасывает этот кадр целиком. Выпавший кадр стоит одного суперкадра
+ * (depth блоков, при depth = 0 - одного блока): декодер восстанавливает границы по номерам блоков.
+ * @param dropped_frame Кадр, выброшенный из потока целиком.
+ * @param destroyed_frame Кадр, все байты которого искажены.
+ */
+void test_stream(int depth, int threads, double byte_error_rate, int dropped_frame = -1, int destroyed_frame = -1) {
+   std::cout << "Test stream encode/decode, interleaving depth: " << depth << ", threads: " << threads
+             << ", dropped frame: " << dropped_frame << ", destroyed frame: " << destroyed_frame << "... ";
+   const auto dir = std::filesystem::temp_directory_path();
+   const std::string plain = (dir / "rsexh_stream_plain.bin").string();
+   const std::string encoded = (dir / "rsexh_stream_encoded.bin").string();
+   const std::string decoded = (dir / "rsexh_stream_decoded.bin").string();
+   std::vector<uint8_t> data(30017);
+   for (auto& el : data)
+      el = roll_uint() & 255;
+   write_file(plain, data);
+   const stream::Options options{depth, threads};
+   const int encode_code = stream::EncodeStream(plain, encoded, options);
+   auto channel = read_file(encoded);
+   int flipped = 0;
+   for (auto& el : channel) {
+      if (roll_error(byte_error_rate)) {
+         el ^= 1 << (roll_uint() % 8);
+         flipped++;
+      }
+   }
+   static const rsexh::RsExh code;
+   const stream::FrameLayout layout{code};
+   if (destroyed_frame >= 0) {
+      for (int i = 0; i < layout.mFrameBytes; ++i)
+         channel[std::size_t(destroyed_frame) * layout.mFrameBytes + i] ^= 0xff;
+   }
+   if (dropped_frame >= 0) {
+      const auto frame = channel.begin() + std::size_t(dropped_frame) * layout.mFrameBytes;
+      channel.erase(frame, frame + layout.mFrameBytes);
+   }
+   write_file(encoded, channel);
+   stream::DecodeStats stats;
+   const int decode_code = stream::DecodeStream(encoded, decoded, options, &stats);
+   // Сравнение по блокам полезной нагрузки: потерянные блоки заменены нулями той же длины.
+   const auto output = read_file(decoded);
+   const std::size_t payload = layout.mPayloadBytes;
+   int wrong_blocks = 0;
+   for (std::size_t i = 0; i < data.size() && output.size() == data.size(); i += payload) {
+      const std::size_t end = std::min(i + payload, data.size());
+      wrong_blocks += !std::equal(data.begin() + i, data.begin() + end, output.begin() + i);
+   }
+   // Искаженный кадр губит свой суперкадр; потерянные в нем концевые блоки данными не считаются.
+   const int unit = std::max(depth, 1);
+   const int data_blocks = (data.size() + payload - 1) / payload;
+   const int destroyed_first = destroyed_frame / unit * unit;
+   const int expected_lost = (dropped_frame < 0 ? 0 : unit) +
+                             (destroyed_frame < 0 ? 0 : std::max(0, std::min(destroyed_first + unit, data_blocks) - destroyed_first));
+   const bool is_ok = encode_code == 0 && decode_code == (expected_lost == 0 ? 0 : 2) && output.size() == data.size() &&
+                      wrong_blocks == expected_lost && stats.mLost == expected_lost;
+   std::cout << "flipped bits: " << flipped << ", erased symbols: " << stats.mErasedSum << ", lost blocks: " << stats.mLost
+             << ", skipped frames: " << stats.mSkippedFrames << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   std::filesystem::remove(plain);
+   std::filesystem::remove(encoded);
+   std::filesystem::remove(decoded);
+   assert(is_ok);
+}
+
+/**
+ * Ложные исправления РС в потоке: во второе слово каждого кадра данных (первое - заголовок) вносится 4-ошибка, которую декодер РС
+ * исправляет в чужое кодовое слово (3-ошибка при d = 6 так исправиться не может). Проверенное декодирование должно найти и стереть их все.
+ */
+void test_stream_miscorrections() {
+   std::cout << "Test stream miscorrection detection... ";
+   const auto dir = std::filesystem::temp_directory_path();
+   const std::string plain = (dir / "rsexh_miscorrect_plain.bin").string();
+   const std::string encoded = (dir / "rsexh_miscorrect_encoded.bin").string();
+   const std::string decoded = (dir / "rsexh_miscorrect_decoded.bin").string();
+   static rsexh::RsExh code;
+   code.SwitchToDirect(true);
+   constexpr int n = rsexh::RsExh::N;
+   std::vector<uint8_t> data(40 * 125);
+   for (auto& el : data)
+      el = roll_uint() & 255;
+   write_file(plain, data);
+   stream::Options options{0, 2, true};
+   stream::EncodeStream(plain, encoded, options);
+   auto channel = read_file(encoded);
+   const stream::FrameLayout layout{code};
+   const int frame_bytes = layout.mFrameBytes;
+   const int frames = data.size() / layout.mPayloadBytes; // Кадры данных; концевые блоки не трогаем.
+   auto nibble = [](uint8_t* frame, int g) -> uint8_t { return (g % 2 == 0) ? (frame[g / 2] >> 4) : (frame[g / 2] & 15); };
+   for (int f = 0; f < frames; ++f) {
+      uint8_t* frame = channel.data() + std::size_t(f) * frame_bytes;
+      std::vector<int> word(n);
+      for (;;) {
+         for (int t = 0; t < n; ++t)
+            word[t] = nibble(frame, n + t);
+         const int positions[4] = {int(roll_uint() % 4), 4 + int(roll_uint() % 4), 8 + int(roll_uint() % 4), 12 + int(roll_uint() % 3)};
+         for (const int pos : positions)
+            word[pos] ^= 1 + roll_uint() % 15;
+         auto trial = word;
+         if (code.mDirect->Correct(trial) != rsexh::InnerStatus::Failed)
+            break;
+      }
+      for (int t = 0; t < n; ++t)
+         frame[(n + t) / 2] = ((n + t) % 2 == 0) ? ((frame[(n + t) / 2] & 15) | (word[t] << 4)) : ((frame[(n + t) / 2] & 0xF0) | word[t]);
+   }
+   write_file(encoded, channel);
+   stream::DecodeStats verified;
+   stream::DecodeStream(encoded, decoded, options, &verified);
+   const bool is_ok_verified = read_file(decoded) == data && verified.mLost == 0 && verified.mMiscorrections == frames;
+   options.mVerify = false;
+   stream::DecodeStats unverified;
+   stream::DecodeStream(encoded, decoded, options, &unverified);
+   const bool is_ok = is_ok_verified && read_file(decoded) != data && unverified.mLost == 0;
+   std::cout << "frames: " << frames << ", detected miscorrections: " << verified.mMiscorrections
+             << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   std::filesystem::remove(plain);
+   std::filesystem::remove(encoded);
+   std::filesystem::remove(decoded);
+   assert(is_ok);
+}
+
+void test_file_protection() {
+   std::cout << "Test file protection (protect/verify/repair)... ";
+   const auto dir = std::filesystem::temp_directory_path();
+   const std::string path = (dir / "rsexh_protect.bin").string();
+   const std::string sidecar = path + ".rsx";
+   std::vector<uint8_t> data(250007);
+   for (auto& el : data)
+      el = roll_uint() & 255;
+   write_file(path, data);
+   const int protect_code = parity::Protect(path, sidecar, 2);
+   const int clean_code = parity::Verify(path, sidecar, 2);
+   static const rsexh::RsExh code;
+   const parity::OuterCode outer;
+   const parity::Layout layout{data.size(), outer.K, outer.N - outer.K};
+   auto damaged = data;
+   // Регион 3 группы 0 стерт целиком, одиночные байты искажены в других регионах.
+   for (int i = 3 * parity::kRegionBytes; i < 4 * parity::kRegionBytes; ++i)
+      damaged[i] ^= 0x5a;
+   for (int i = 0; i < 20; ++i)
+      damaged[4 * parity::kRegionBytes + roll_uint() % (damaged.size() - 4 * parity::kRegionBytes)] ^= 1 << (roll_uint() % 8);
+   // Ложное исправление РС: 4 искаженных полубайта слова 7 региона 4 группы 1.
+   const auto parity_bytes = read_file(sidecar);
+   const std::size_t word_offset = (std::size_t(layout.mK) + 4) * parity::kRegionBytes + 7 * parity::kWordBytes;
+   const uint8_t* word_parity = parity_bytes.data() + layout.InnerParityOffset(1, 4);
+   constexpr int K = rsexh::RsExh::K;
+   for (;;) {
+      std::vector<int> v(rsexh::RsExh::N);
+      for (int j = 0; j < K; ++j)
+         v[j] = parity::GetNibble(damaged.data() + word_offset, j);
+      for (int t = 0; t < rsexh::RsExh::R; ++t)
+         v[K + t] = parity::GetNibble(word_parity, 7 * rsexh::RsExh::R + t);
+      std::set<int> positions;
+      while (positions.size() < 4)
+         positions.insert(roll_uint() % K);
+      for (const int pos : positions)
+         v[pos] ^= 1 + roll_uint() % 15;
+      auto trial = v;
+      if (code.Correct(trial) == rsexh::InnerStatus::Failed)
+         continue;
+      for (int j = 0; j < K; ++j)
+         parity::SetNibble(damaged.data() + word_offset, j, v[j]);
+      break;
+   }
+   write_file(path, damaged);
+   const int damaged_code = parity::Verify(path, sidecar, 2);
+   const int repair_code = parity::Repair(path, sidecar, 2);
+   const bool is_repaired = read_file(path) == data;
+   const int repaired_code = parity::Verify(path, sidecar, 2);
+   const bool is_ok = protect_code == 0 && clean_code == 0 && damaged_code == 2 && repair_code == 0 && is_repaired && repaired_code == 0;
+   std::cout << "return codes: protect " << protect_code << ", verify " << clean_code << '/' << damaged_code << '/' << repaired_code
+             << ", repair " << repair_code << ", file restored: " << (is_repaired ? "yes" : "no") << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   std::filesystem::remove(path);
+   std::filesystem::remove(sidecar);
+   assert(is_ok);
+}
+
+void test_error_injection(double ber, int blocks) {
+   std::cout << "Test geometric-skip error injection, channel BER: " << ber << "... ";
+   constexpr int N = 32;
+   constexpr int n = rsexh::RsExh::N;
+   rsexh::Matrix<int> v(N, std::vector<int>(n, 0));
+   auto measure = [&](auto&& inject, long long& flipped) {
+      flipped = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (int b = 0; b < blocks; ++b) {
+         flipped += inject();
+      }
+      return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / blocks;
+   };
+   channel::CounterRng rng{seed, 0};
+   const uint64_t threshold = channel::CounterRng::Threshold(ber);
+   long long flipped_bernoulli, flipped_skip;
+   const double ns_bernoulli = measure([&] {
+      long long flipped = 0;
+      for (auto& word : v) {
+         for (auto& nibble : word) {
+            for (int i = 0; i < 4; ++i) {
+               const bool error = rng.Bernoulli(threshold);
+               nibble ^= static_cast<int>(error) << i;
+               flipped += error;
+            }
+         }
+      }
+      return flipped;
+   }, flipped_bernoulli);
+   const channel::Bsc bsc{ber};
+   const double ns_skip = measure([&] {
+      CountingTarget target{v};
+      bsc.Apply(target.Symbols(), rng, target);
+      return target.mFlipped;
+   }, flipped_skip);
+   const double bits = 1. * blocks * N * n * 4;
+   const double rate = flipped_skip / bits;
+   const bool is_ok = std::abs(rate - ber) < 5. * std::sqrt(ber / bits) + 1.e-12;
+   std::cout << "per block: Bernoulli: " << ns_bernoulli << " ns (rate " << flipped_bernoulli / bits << "), skip: "
+             << ns_skip << " ns (rate " << rate << ")" << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_importance_sampling(double ber, long long blocks_per_layer, int plain_blocks) {
+   std::cout << "Test importance sampling, channel BER: " << ber << "... ";
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   sim::ImportanceConfig config;
+   config.mBer = ber;
+   config.mBlocksPerLayer = blocks_per_layer;
+   config.mSeed = seed;
+   const auto start = std::chrono::steady_clock::now();
+   const auto result = sim::RunImportance(code, config);
+   const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+   std::cout << "decoder BER: " << result.mBer << " [" << result.mBerLow << ", " << result.mBerHigh << "], block error rate: "
+             << result.mFer << " [" << result.mFerLow << ", " << result.mFerHigh << "], heavy words 1.." << result.mMaxHeavy
+             << " (errors per word up to " << result.mMaxErrors << ")"
+             << ", blocks: " << result.mBlocks << ", " << ms << " ms";
+   bool is_ok = result.mBerLow <= result.mBer && result.mBer <= result.mBerHigh &&
+                result.mFerLow <= result.mFer && result.mFer <= result.mFerHigh && result.mFer >= result.mBer;
+   // Интервал должен быть информативным и там, где обычный Монте-Карло отказов не видит: отказы найдены
+   // (нижняя граница не нулевая), а верхняя граница - того же порядка, что и оценка.
+   is_ok = is_ok && result.mFerLow > 0. && result.mFerHigh <= 4. * result.mFer && result.mBerHigh <= 5. * result.mBer;
+   if (plain_blocks > 0) {
+      sim::Config plain;
+      plain.mBer = ber;
+      plain.mBlocks = plain_blocks;
+      plain.mSeed = seed;
+      const auto reference = sim::Run(code, plain);
+      const double reference_fer = (1. * reference.mBlockErrors) / reference.mBlocks;
+      std::cout << ", plain Monte Carlo: " << reference.Ber() << " (" << reference.mBlockErrors << " block errors of "
+                << reference.mBlocks << ")";
+      // Обычный Монте-Карло - независимая оценка того же: должна попасть в доверительные интервалы.
+      is_ok = is_ok && result.mBerLow <= reference.Ber() && reference.Ber() <= result.mBerHigh;
+      is_ok = is_ok && result.mFerLow <= reference_fer && reference_fer <= result.mFerHigh;
+   }
+   std::cout << ", " << (is_ok ? "Ok." : "Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_sweep() {
+   std::cout << "Test BER/FER sweep..." << std::endl;
+   std::vector<sweep::Profile> profiles(2);
+   bool is_ok = sweep::ParseProfile("r5-hamming-c2", profiles[0]) && sweep::ParseProfile("r6-golay-c2", profiles[1]);
+   sweep::Profile unsupported;
+   is_ok = is_ok && !sweep::ParseProfile("r7-hamming-c2", unsupported) && !sweep::ParseProfile("r5-bch-c1", unsupported);
+   sweep::StopRule rule;
+   rule.mTargetBlockErrors = 20;
+   rule.mMaxBlocks = 1024;
+   rule.mRoundBlocks = 256;
+   rule.mSeed = seed;
+   const auto points = sweep::Run(profiles, {0.02, 0.03}, rule, [](const sweep::Point&) {});
+   std::ostringstream csv;
+   sweep::WriteCsv(csv, points);
+   std::cout << csv.str();
+   is_ok = is_ok && points.size() == 4;
+   for (const auto& p : points) {
+      is_ok = is_ok && p.mFerLow <= p.mFer && p.mFer <= p.mFerHigh && p.mResult.mBlocks <= rule.mMaxBlocks;
+      is_ok = is_ok && (p.mStop == "errors" ? p.mResult.mBlockErrors >= rule.mTargetBlockErrors : p.mResult.mBlocks == rule.mMaxBlocks || p.mStop == "width");
+   }
+   // Код Голея (D = 7) сильнее расширенного кода Хэмминга (D = 4).
+   is_ok = is_ok && points[2].mResult.Ber() <= points[0].mResult.Ber();
+   // Порция по умолчанию не зависит от числа потоков, поэтому не зависит и точка остановки.
+   sweep::StopRule by_default;
+   by_default.mTargetBlockErrors = 20;
+   by_default.mMaxBlocks = 4096;
+   by_default.mSeed = seed;
+   auto run_point = [&](int threads) {
+      by_default.mThreads = threads;
+      sweep::Point point;
+      sweep::WithCode(profiles[0], [&](const auto& code) { point = sweep::RunPoint(code, profiles[0], 0.02, by_default); });
+      return point;
+   };
+   const auto one = run_point(1);
+   const auto three = run_point(3);
+   is_ok = is_ok && one.mResult.mBlocks == three.mResult.mBlocks && one.mResult.mBlockErrors == three.mResult.mBlockErrors &&
+      one.mResult.mBitErrors == three.mResult.mBitErrors && one.mStop == three.mStop;
+   std::cout << (is_ok ? "Ok." : "Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_erasure_analysis(double ber, int blocks) {
+   std::cout << "Test erasure pattern analysis, channel BER: " << ber << "..." << std::endl;
+   auto check = [](const char* name, const hamming::Matrix<int>& H, int distance, uint64_t min_weight_count) {
+      const auto start = std::chrono::steady_clock::now();
+      const auto spectrum = analysis::EnumerateErasures(H);
+      const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      const int R = H.size();
+      bool is_ok = spectrum.MinUnrecoverable() == distance && spectrum.mUnrecoverable[distance] == min_weight_count;
+      for (int w = R + 1; w <= spectrum.mN; ++w)
+         is_ok = is_ok && spectrum.mUnrecoverable[w] == spectrum.mTotal[w];
+      std::cout << " ... " << name << ": unrecoverable by weight";
+      for (int w = distance; w <= R + 1; ++w)
+         std::cout << ' ' << w << ':' << spectrum.mUnrecoverable[w] << '/' << spectrum.mTotal[w];
+      std::cout << ", full-rank patterns visited: " << spectrum.mVisited << ", " << ms << " ms" << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+      assert(is_ok);
+      return spectrum;
+   };
+   static hamming::HammingExtended<int, 6, 10> ex_hamming;
+   // Слова веса 4 расширенного кода Хэмминга (32, 26): 32 * 31 * 30 / 24; слова веса 7 кода Голея: 253.
+   const auto spectrum = check("(32, 26)", ex_hamming.mHsys, 4, 1240);
+   static hamming::HammingExtended<int, 11, 10> golay{hamming::ToMatrix(hamming::kGolayParityMatrix), 7};
+   check("Golay (23, 12)", golay.mHsys, 7, 253);
+
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   const double p_word = analysis::InnerWordFailure(ber, rsexh::RsExh::N, 2);
+   const double fer = spectrum.FailureProbability(p_word);
+   sim::Config config;
+   config.mBer = ber;
+   config.mBlocks = blocks;
+   config.mSeed = seed;
+   const auto result = sim::Run(code, config);
+   double low, high;
+   sweep::WilsonInterval(result.mBlockErrors, result.mBlocks, 3., low, high);
+   const bool is_ok = fer >= low && fer <= high;
+   std::cout << " ... RS word failure: " << p_word << ", analytical block error rate: " << fer << ", Monte Carlo: "
+             << (1. * result.mBlockErrors) / result.mBlocks << " [" << low << ", " << high << "]" << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_inner_spectrum(double ps, int words) {
+   std::cout << "Test RS weight enumerator and decoding outcomes, symbol error rate: " << ps << "..." << std::endl;
+   static rsexh::RsExh code;
+   constexpr int n = rsexh::RsExh::N;
+   constexpr int r = rsexh::RsExh::R;
+   bool is_ok = true;
+   for (int t = 1; t <= 2; ++t) {
+      const auto mode = t == 1 ? rsexh::CorrectionMode::Correct1 : rsexh::CorrectionMode::Correct2;
+      const auto start = std::chrono::steady_clock::now();
+      const auto classes = analysis::ClassifySyndromes(code, mode, 61);
+      const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      const auto spectrum = analysis::RsSpectrum(n, r, t);
+      // Табличный декодер - декодер с ограниченным расстоянием: исправимы ровно синдромы шаров радиуса t.
+      uint64_t codewords = 0;
+      uint64_t in_balls = 0;
+      for (int w = 0; w <= n; ++w) {
+         codewords += spectrum.mWeights[w];
+         in_balls += (w <= t ? spectrum.Patterns(w) : 0) + spectrum.mMiscorrected[w] + spectrum.mUndetected[w];
+      }
+      is_ok = is_ok && classes.mCollisions == 0 && classes.mWrong == 0 && classes.mOutsideDecoded == 0 &&
+              classes.mCorrected1 == spectrum.Patterns(1) && classes.mCorrected2 == (t == 2 ? spectrum.Patterns(2) : 0) &&
+              codewords == (uint64_t(1) << (4 * (n - r))) && in_balls == classes.mBall * codewords;
+      const auto outcome = spectrum.Probabilities(ps);
+      std::cout << " ... t = " << t << ": corrected 1/2-errors: " << classes.mCorrected1 << '/' << classes.mCorrected2
+                << ", failed outside the balls: " << classes.mOutside - classes.mOutsideDecoded << '/' << classes.mOutside << " (" << ms << " ms), A_" << r + 1 << " = " << spectrum.mWeights[r + 1]
+                << ", correct: " << outcome.mCorrect << ", detected: " << outcome.mDetected << ", miscorrected: "
+                << outcome.mMiscorrected << ", undetected: " << outcome.mUndetected;
+      // Моделирование q-ичного симметричного канала на нулевом кодовом слове.
+      std::mt19937 gen{seed};
+      std::uniform_real_distribution<double> uniform{0., 1.};
+      std::uniform_int_distribution<int> value{1, n};
+      long long miscorrected = 0;
+      long long detected = 0;
+      std::vector<int> v(n);
+      for (int i = 0; i < words; ++i) {
+         for (auto& el : v)
+            el = uniform(gen) < ps ? value(gen) : 0;
+         const auto status = code.Correct(v, mode);
+         const bool is_zero = std::all_of(v.begin(), v.end(), [](int el) { return el == 0; });
+         detected += status == rsexh::InnerStatus::Failed;
+         miscorrected += status != rsexh::InnerStatus::Failed && status != rsexh::InnerStatus::Clean && !is_zero;
+      }
+      const double expected = outcome.mMiscorrected * words;
+      const double expected_detected = outcome.mDetected * words;
+      const bool is_close = std::abs(miscorrected - expected) < 5. * std::sqrt(expected) + 1. &&
+                            std::abs(detected - expected_detected) < 5. * std::sqrt(expected_detected) + 1.;
+      std::cout << ", Monte Carlo miscorrected: " << (1. * miscorrected) / words << ", detected: " << (1. * detected) / words
+                << (is_close ? ", Ok." : ", Failure.") << std::endl;
+      is_ok = is_ok && is_close;
+   }
+   assert(is_ok);
+}
+
+void test_inner_exhaustive(int codewords) {
+   std::cout << "Test exhaustive 1- and 2-error patterns, codewords: " << codewords << "..." << std::endl;
+   static rsexh::RsExh code;
+   static const rsexh::DirectCorrector<rsexh::RsExh> direct{code};
+   auto reference = [](std::vector<int>& v) { return code.Correct(v); };
+   verify::Config config;
+   config.mCodewords = codewords;
+   config.mSeed = seed;
+   const auto report = verify::Run(code, reference, [](std::vector<int>& v) { return direct.Correct(v); }, config);
+   const uint64_t patterns = uint64_t(codewords) * (15 * 15 + 105 * 15 * 15);
+   bool is_ok = report.mPatterns == patterns && report.mMismatches == 0 && report.mReferenceFailures == 0;
+   std::cout << " ... direct-indexed vs LUT: " << report.mPatterns << " patterns, mismatches: " << report.mMismatches
+             << ", reference failures: " << report.mReferenceFailures << ", " << report.PatternsPerSecond() << " patterns/s, LUT: "
+             << report.ReferenceNs() << " ns, direct: " << report.VariantNs() << " ns" << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   // Вариант без исправления 2-ошибок должен расходиться с эталоном на каждом 2-векторе.
+   config.mCodewords = 1;
+   const auto broken = verify::Run(code, reference, [](std::vector<int>& v) { return direct.Correct(v, rsexh::CorrectionMode::Correct1); }, config);
+   is_ok = is_ok && broken.mMismatches == 105 * 15 * 15 && !broken.mReported.empty() &&
+           broken.mReported.front().mPos2 >= 0 && broken.mReported.front().mActual == rsexh::InnerStatus::Failed;
+   std::cout << " ... 1-error-only variant: mismatches: " << broken.mMismatches << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_telemetry(double ber, long long blocks) {
+   std::cout << "Test decoder telemetry, BER: " << ber << ", blocks: " << blocks << "..." << std::endl;
+   if (!telemetry::IsEnabled()) {
+      std::cout << " ... disabled at compile time (RSEXH_TELEMETRY=0), skipped." << std::endl;
+      return;
+   }
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   sim::Config config;
+   config.mBer = ber;
+   config.mBlocks = blocks;
+   config.mThreads = 4;
+   config.mSeed = seed;
+   const auto before = telemetry::Take();
+   const auto result = sim::Run(code, config);
+   const auto s = telemetry::Take() - before;
+   using telemetry::Counter;
+   uint64_t erasure_records = 0;
+   uint64_t latency_records = 0;
+   for (int b = 0; b < telemetry::kBuckets; ++b) {
+      erasure_records += s.mHistograms[int(telemetry::Histogram::OuterErasures)][b];
+      latency_records += s.mHistograms[int(telemetry::Histogram::DecodeLatency)][b];
+   }
+   const uint64_t outcomes = s[Counter::InnerClean] + s[Counter::InnerCorrected1] + s[Counter::InnerCorrected2] + s[Counter::InnerFailed];
+   // Счетчики всех 4 потоков (уже завершившихся) сходятся с итогами моделирования.
+   bool is_ok = s[Counter::OuterBlocks] == uint64_t(result.mBlocks) && erasure_records == s[Counter::OuterBlocks] &&
+                latency_records == s[Counter::OuterBlocks] && s[Counter::InnerWords] == outcomes && outcomes > 0 &&
+                s[Counter::InnerCorrected2] > 0 && s[Counter::ShiftIterations] >= s[Counter::InnerCorrected2] &&
+                s[Counter::OuterFailures] <= uint64_t(result.mBlockErrors);
+   std::cout << " ... ";
+   telemetry::Print(std::cout, s);
+   // Итеративное декодирование: пробные декодирования ListDecode не считаются исходами слов,
+   // а записанный исход блока совпадает с возвращенным.
+   hamming::CodeWord<int, code.M2> a(code.mHammingCode.K);
+   for (auto& el : a) {
+      el.mStatus = hamming::SymbolStatus::Normal;
+      for (auto& symbol : el.mSymbol)
+         symbol = roll_uint() & 15;
+   }
+   std::vector<std::vector<int>> v;
+   code.EncodeBlock(a, v);
+   for (int i = 0; i < 4; ++i) { // 3-ошибки в 4 словах: однократное декодирование не справляется.
+      for (int j = 0; j < 3; ++j)
+         v[i][j] = (v[i][j] + 1) % 16;
+   }
+   hamming::CodeWord<int, code.M2> decoded;
+   int erased;
+   const auto before_iterative = telemetry::Take();
+   const bool is_decoded = code.DecodeBlockIterative(v, decoded, erased);
+   const auto iterative = telemetry::Take() - before_iterative;
+   is_ok = is_ok && iterative[Counter::InnerWords] == v.size() && iterative[Counter::InnerFailed] == 4 &&
+           iterative[Counter::OuterBlocks] == 1 && iterative[Counter::OuterFailures] == uint64_t(!is_decoded);
+   std::cout << " ... iterative block: " << (is_decoded ? "decoded" : "lost") << ", inner words counted: "
+             << iterative[Counter::InnerWords] << " of " << v.size() << std::endl;
+   // Чистый блок в ленивом режиме не доходит до внешнего декодера: отказ не записывается,
+   // каким бы ни было состояние внешнего кода после прошлого блока.
+   code.EncodeBlock(a, v);
+   code.mHammingCode.mIsSolved = false;
+   const auto before_lazy = telemetry::Take();
+   const bool is_lazy_decoded = code.DecodeBlock(v, decoded, erased);
+   const auto lazy = telemetry::Take() - before_lazy;
+   is_ok = is_ok && is_lazy_decoded && lazy[Counter::OuterBlocks] == 1 && lazy[Counter::OuterFailures] == 0;
+   std::cout << " ... " << (is_ok ? "Ok." : "Failure.") << std::endl;
+   assert(is_ok);
+}
+
+void test_channel_models() {
+   std::cout << "Test channel models..." << std::endl;
+   constexpr std::size_t symbols = 1 << 20;
+   const double bits = 4. * symbols;
+   std::vector<uint8_t> buffer(symbols);
+   std::vector<uint8_t> erased(symbols);
+   channel::CounterRng rng{seed, 1};
+   // Доля ошибок бит и доля ошибок, отстоящих от предыдущей не более чем на 8 бит (признак пакетов).
+   auto measure = [&](const auto& model, double& clustered) {
+      std::fill(buffer.begin(), buffer.end(), 0);
+      std::fill(erased.begin(), erased.end(), 0);
+      channel::BufferTarget<uint8_t> target{buffer.data(), erased.data()};
+      model.Apply(symbols, rng, target);
+      long long errors = 0;
+      long long close = 0;
+      long long last = -100;
+      for (std::size_t i = 0; i < symbols; ++i) {
+         for (int b = 0; b < 4; ++b) {
+            if ((buffer[i] >> b) & 1) {
+               const long long pos = 4 * i + b;
+               close += pos - last <= 8;
+               last = pos;
+               errors++;
+            }
+         }
+      }
+      clustered = errors > 0 ? (1. * close) / errors : 0.;
+      return errors / bits;
+   };
+   double clustered_bsc, clustered_ge, clustered_awgn, unused;
+   const channel::Bsc bsc{0.002};
+   const double rate_bsc = measure(bsc, clustered_bsc);
+   const channel::GilbertElliott ge{1.e-4, 1.e-2, 0., 0.2};
+   const double rate_ge = measure(ge, clustered_ge);
+   const channel::BpskAwgn awgn{4.};
+   const double rate_awgn = measure(awgn, clustered_awgn);
+   const channel::PacketErasure packets{0.05, 15};
+   measure(packets, unused);
+   const double erased_fraction = std::count(erased.begin(), erased.end(), 1) / double(symbols);
+   std::cout << " ... BSC: " << rate_bsc << " (clustered " << clustered_bsc << "), Gilbert-Elliott: " << rate_ge
+             << " of " << ge.AverageBer() << " (clustered " << clustered_ge << "), BPSK/AWGN 4 dB: " << rate_awgn
+             << " of " << awgn.HardBer() << ", packet erasure: " << erased_fraction << std::endl;
+   assert(std::abs(rate_bsc - 0.002) < 0.1 * 0.002);
+   assert(std::abs(rate_ge - ge.AverageBer()) < 0.3 * ge.AverageBer());
+   assert(clustered_ge > 10. * clustered_bsc);
+   assert(std::abs(rate_awgn - awgn.HardBer()) < 0.1 * awgn.HardBer());
+   assert(std::abs(erased_fraction - 0.05) < 0.01);
+
+   // Декодер в разных каналах с одинаковой средней вероятностью ошибки бита.
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   sim::Config config;
+   config.mBlocks = 300;
+   config.mSeed = seed;
+   auto report = [&](const char* name, const auto& model) {
+      const auto result = sim::Run(code, config, model);
+      std::cout << " ... " << name << ": decoder BER: " << result.Ber() << ", block errors: " << result.mBlockErrors
+                << " of " << result.mBlocks << std::endl;
+   };
+   const channel::BpskAwgn soft{4.};
+   report("BSC", channel::Bsc{soft.HardBer()});
+   report("Gilbert-Elliott", channel::GilbertElliott{1.e-4, 1.e-2, 0., 100. * soft.HardBer()});
+   report("BPSK/AWGN 4 dB", soft);
+   report("BPSK/AWGN 4 dB, unreliable words erased", channel::BpskAwgn{4., 0.05f});
+   report("packet erasure 5%", channel::PacketErasure{0.05});
+}
+
+double measure_ber(double ber, int factor);
+
+void test_parallel_simulator(double ber, int blocks) {
+   std::cout << "Test parallel simulator, channel BER: " << ber << "... ";
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   sim::Config config;
+   config.mBer = ber;
+   config.mBlocks = blocks;
+   config.mSeed = seed;
+   auto run = [&](int threads, double& ms) {
+      config.mThreads = threads;
+      const auto start = std::chrono::steady_clock::now();
+      const auto result = sim::Run(code, config);
+      ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      return result;
+   };
+   // Последовательная эталонная оценка (с диагностикой гарантированно исправимых ошибок).
+   const double reference = measure_ber(ber, blocks);
+   assert(reference != -1.);
+   double ms_single, ms_parallel;
+   const auto single = run(1, ms_single);
+   const int threads = std::max(4u, std::thread::hardware_concurrency());
+   const auto parallel = run(threads, ms_parallel);
+   const bool is_same = single.mBlocks == parallel.mBlocks && single.mBitErrors == parallel.mBitErrors &&
+                        single.mBlockErrors == parallel.mBlockErrors;
+   std::cout << "decoder BER: " << parallel.Ber() << " (serial: " << reference << "), block errors: " << parallel.mBlockErrors << " of "
+             << parallel.mBlocks << ", 1 thread: " << ms_single << " ms, " << threads << " threads: " << ms_parallel << " ms" << (is_same ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_same);
+}
+
+void test_wide_symbols(int erasures) {
+   std::cout << "Test 4 KiB outer symbols (32, 26), erasures: " << erasures << "... ";
+   static constexpr int M = 512; // 512 * 8 байт.
+   using Code = hamming::HammingExtended<uint64_t, 6, M>;
+   static Code code;
+   hamming::CodeWord<uint64_t, M> a(code.K);
+   for (auto& el : a) {
+      el.mStatus = hamming::SymbolStatus::Normal;
+      for (auto& symbol : el.mSymbol)
+         symbol = (uint64_t(roll_uint()) << 32) | roll_uint();
+   }
+   const int blocks = 200;
+   bool is_ok = true;
+   hamming::CodeWord<uint64_t, M> v;
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < blocks; ++i)
+      v = code.Encode(a);
+   const double encode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   double decode_s = 0.;
+   for (int i = 0; i < blocks; ++i) {
+      auto received = v;
+      for (int j = 0; j < erasures; ++j) {
+         auto& el = received[(i + 7 * j) % code.N];
+         el.mStatus = hamming::SymbolStatus::Erased;
+         el.mSymbol.fill(0);
+      }
+      int erased;
+      start = std::chrono::steady_clock::now();
+      is_ok &= code.Decode(received, erased) && code.mIsSolved;
+      decode_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      is_ok &= received == a;
+   }
+   const double mbytes = blocks * code.K * M * sizeof(uint64_t) / 1.e6;
+   std::cout << "encode: " << mbytes / encode_s << " MB/s, decode: " << mbytes / decode_s << " MB/s"
+             << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
+template <typename Code>
+void test_static_code(const std::string& name, hamming::HammingExtended<int, Code::R, 9>& reference) {
+   std::cout << "Test compile-time outer code " << name << "... ";
+   static constexpr int M = 9;
+   reference.SwitchToSystematic(false);
+   std::array<hamming::CodeElement<int, M>, Code::N> v;
+   hamming::CodeWord<int, M> a(Code::K);
+   bool is_ok = true;
+   for (int k = 0; k < Code::K; ++k)
+      is_ok &= Code::InformationPosition(k) == reference.InformationPositions()[k];
+   for (int round = 0; round < 1000; ++round) {
+      for (auto& el : a) {
+         el.mStatus = hamming::SymbolStatus::Normal;
+         for (auto& symbol : el.mSymbol)
+            symbol = roll_uint() & 15;
+      }
+      Code::Encode(a.data(), v.data());
+      const auto expected = reference.Encode(a);
+      is_ok &= std::equal(v.begin(), v.end(), expected.begin()) && Code::IsCodeword(v.data());
+      const int e = roll_uint() % Code::N;
+      const auto original = v[e];
+      v[e].mStatus = hamming::SymbolStatus::Erased;
+      v[e].mSymbol.fill(-1);
+      Code::RepairSingle(v.data(), e);
+      is_ok &= v[e] == original;
+   }
+   const int blocks = 100000;
+   int sink = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < blocks; ++i) {
+      a[i % Code::K].mSymbol[0] = i & 15;
+      Code::Encode(a.data(), v.data());
+      sink ^= v[Code::N - 1].mSymbol[0];
+   }
+   const double ns_static = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / blocks;
+   start = std::chrono::steady_clock::now();
+   for (int i = 0; i < blocks; ++i) {
+      a[i % Code::K].mSymbol[0] = i & 15;
+      sink ^= reference.Encode(a).back().mSymbol[0];
+   }
+   const double ns_runtime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / blocks;
+   std::cout << "encode: " << ns_static << " ns (runtime matrix: " << ns_runtime << " ns), checksum: " << sink
+             << (is_ok ? ", Ok." : ", Failure.") << std::endl;
+   assert(is_ok);
+}
+
 void test_rs(int input) {
    rsexh::RsExh code;
 
@@ -290,6 +1425,11 @@ double measure_ber(double ber, int factor) {
    long long bits_transmitted = 0;
    long long bits_corrupted = 0;
    double output_ber = 0.;
+   const channel::Bsc bsc{ber};
+   // Генератор канала поверх общего генератора тестов.
+   struct {
+      double Uniform() { return (roll_uint() + 1.) / 4294967296.; }
+   } uniform;
    for (int f = 0; f < factor; f++) {
       a_received.resize(code.mHammingCode.N);
       // Source
@@ -300,124 +1440,25 @@ double measure_ber(double ber, int factor) {
       }
       bits_transmitted += code.mHammingCode.K * code.M2 * 4;
       // hamming::show_codeword(a, code, "Input a: ");
-      // Hamming encode
-      // std::cout << "Hamming encode\n";
-      auto s_h = code.mHammingCode.Encode(a);
-      std::vector<int> a_rs(code.K);
+      // Hamming encode, RS encode
       std::vector<std::vector<int>> v;
-      // hamming::show_codeword(s_h, code.mHammingCode.K, "Hamming output s: ");
-      // RS encode
-      // std::cout << "RS encode\n";
-      v.clear();
-      for (const auto& el : s_h) {
-         assert(code.K == el.mSymbol.size());
-         for (int i = 0; i < code.K; ++i)
-            a_rs[i] = el.mSymbol[i];
-         v.push_back(rsexh::Encode(a_rs, code.mGf));
-      }
+      code.EncodeBlock(a, v);
       // rsexh::show_matrix(v, "RS outputs: ");
       // Channel
-      std::vector<int> error_q; // Кратности ошибки.
-      for (int pos1 = 0; auto& el : v) {
-         error_q.push_back(0);
-         for (int pos2 = 0; auto& el2 : el) {
-            bool was_error = false;
-            for (int i=0; i<4; ++i) {
-               const bool error = roll_error(ber);
-               was_error |= error;
-               el2 ^= (static_cast<int>(error) << i); // Полубайт.
-            }
-            error_q.back() += was_error;
-            pos2++;
-         }
-         pos1++;
-      }
+      CountingTarget target{v};
+      bsc.Apply(target.Symbols(), uniform, target);
+      const std::vector<int>& error_q = target.mWordErrors; // Кратности ошибки.
       // Decode
       std::vector<int> was_1_error_correction(v.size());
       std::vector<int> was_2_error_correction(v.size());
-      for (int i = 0; auto& el : v) {
-         a_received[i].mStatus = hamming::SymbolStatus::Uninitialized;
-         // std::cout << "Calculate cyndrome 1\n";
-         auto c = rsexh::CalculateSyndrome(el, code.R, code.mGf);
-         bool is_ok = true;
-         for (const auto& el_c: c) {
-            is_ok &= el_c == 0;
-         }
-         if (!is_ok) {
-            // std::cout << "First cyndrome check: " << "Failure" << '\n';
-            if (auto it = code.mLut_1_errors.find(c); it != code.mLut_1_errors.end()) {
-               const auto [pos, corrector_idx] = it.operator*().second;
-               const int channel_value = el.at(pos);
-               el[pos] = code.mGf.Sub(channel_value - 1, corrector_idx) + 1; // idx = value - 1 => value = idx + 1.
-               is_ok = true;
-               was_1_error_correction[i] = 1;
-            }
-         }
-         if (is_ok) {
-            auto a_dec = rsexh::Decode(el, code.R, code.mGf);
-            for (int j=0; j<a_dec.size(); ++j) {
-               a_received[i].mSymbol[j] = a_dec.at(j);
-            }
-            a_received[i].mStatus = hamming::SymbolStatus::Normal;
-         } else {
-            for (int j=0; j<code.M2; ++j) {
-               a_received[i].mSymbol[j] = -1;
-            }
-            a_received[i].mStatus = hamming::SymbolStatus::Erased;
-         }
-         i++;
-      }
-      for (int i = 0; auto& el : v) {
-         if (a_received.at(i).mStatus == hamming::SymbolStatus::Normal) {
-            i++;
-            continue;
-         }
-         // std::cout << "Calculate cyndrome 2\n";
-         auto c = rsexh::CalculateSyndrome(el, code.R, code.mGf);
-         bool is_ok = true;
-         for (const auto& el_c: c) {
-            is_ok &= el_c == 0;
-         }
-         if (!is_ok) {
-            // std::cout << "First cyndrome check: " << "Failure" << '\n';
-            // 2-кратные ошибки.
-            for (int k = 0; k < code.N - 1; k++) {
-               if (auto it = code.mLut_2_errors.find(c); it != code.mLut_2_errors.end()) {
-                  const auto [pos_2nd, corrector_indices] = it.operator*().second;
-                  const int idx_1 = k;
-                  const int idx_2 = pos_2nd + k;
-                  if (idx_2 < el.size()) {
-                     const int channel_value_1 = el.at(idx_1);
-                     const int channel_value_2 = el.at(idx_2);
-                     const auto [corrector_idx_1, corrector_idx_2] = corrector_indices;
-                     el[idx_1] = code.mGf.Sub(channel_value_1 - 1, corrector_idx_1) + 1;
-                     el[idx_2] = code.mGf.Sub(channel_value_2 - 1, corrector_idx_2) + 1;
-                  }
-                  was_2_error_correction[i] = 1;
-                  is_ok = true;
-                  break;
-               }
-               rsexh::ShiftLeftSyndrome<code.p, code.q>(c); // Сдвиг - имеется ввиду сдвиг соответствующего вектора ошибки.
-            }
-         }
-         if (is_ok) {
-            auto a_dec = rsexh::Decode(el, code.R, code.mGf);
-            for (int j=0; j<a_dec.size(); ++j) {
-               a_received[i].mSymbol[j] = a_dec.at(j);
-            }
-            a_received[i].mStatus = hamming::SymbolStatus::Normal;
-         } else {
-            for (int j=0; j<code.M2; ++j) {
-               a_received[i].mSymbol[j] = -1;
-            }
-            a_received[i].mStatus = hamming::SymbolStatus::Erased;
-         }
+      int erased;
+      // Ленивое декодирование: проверочные слова РС декодируются, только если нужны внешнему коду.
+      const bool is_ok_hamming = code.DecodeBlock(v, a_received, erased);
+      for (int i = 0; const auto status : code.mLastStatus) {
+         was_1_error_correction[i] = status == rsexh::InnerStatus::Corrected1;
+         was_2_error_correction[i] = status == rsexh::InnerStatus::Corrected2;
          i++;
       }
-      // std::cout << "Decode Hamming: " << a_received.size() << std::endl;
-      int erased;
-      // hamming::show_codeword(a_received, code.mHammingCode.K, "Received Hamming input v: ");
-      const bool is_ok_hamming = code.mHammingCode.Decode(a_received, erased);
       bool is_equal = true;
       for (int i = 0; i < code.mHammingCode.K; ++i) {
          is_equal &= a.at(i) == a_received.at(i);
@@ -474,14 +1515,330 @@ double measure_ber(double ber, int factor) {
 }
 
 
+/**
+ * Режимы командной строки. Без аргументов - тесты и оценка BER.
+ */
+int run_cli(int argc, char* argv[]) {
+   const std::string mode = argv[1];
+   stream::Options options;
+   while ((mode == "encode" || mode == "decode") && argc > 2) {
+      const std::string flag = argv[2];
+      if (flag == "--verify") {
+         options.mVerify = true;
+         argv++;
+         argc--;
+         continue;
+      }
+      if ((flag != "-i" && flag != "-t") || argc < 4) {
+         break;
+      }
+      const int value = std::atoi(argv[3]);
+      if (value < 1) {
+         std::cerr << "Interleaving depth and thread count must be positive\n";
+         return 1;
+      }
+      (flag == "-i" ? options.mDepth : options.mThreads) = value;
+      argv += 2;
+      argc -= 2;
+   }
+   const std::string input = argc > 2 ? argv[2] : "-";
+   const std::string output = argc > 3 ? argv[3] : "-";
+   if (mode == "encode") {
+      return stream::EncodeStream(input, output, options);
+   }
+   if (mode == "decode") {
+      return stream::DecodeStream(input, output, options);
+   }
+   if (mode == "sim") {
+      if (argc < 3) {
+         std::cerr << "Channel BER is required\n";
+         return 1;
+      }
+      static rsexh::RsExh code;
+      code.mHammingCode.SwitchToSystematic(false);
+      sim::Config config;
+      config.mBer = std::atof(argv[2]);
+      config.mBlocks = argc > 3 ? std::atoll(argv[3]) : 1000000;
+      config.mThreads = argc > 4 ? std::atoi(argv[4]) : 0;
+      config.mSeed = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 1;
+      const auto result = sim::Run(code, config);
+      std::cout << "channel BER: " << config.mBer << "\tdecoder BER: " << result.Ber() << "\tbit errors: " << result.mBitErrors
+                << "\tblock errors: " << result.mBlockErrors << "\tblocks: " << result.mBlocks << std::endl;
+      if (telemetry::IsEnabled())
+         telemetry::Print(std::cout, telemetry::Take());
+      return 0;
+   }
+   if (mode == "sim-is") {
+      if (argc < 3) {
+         std::cerr << "Channel BER is required\n";
+         return 1;
+      }
+      static rsexh::RsExh code;
+      code.mHammingCode.SwitchToSystematic(false);
+      sim::ImportanceConfig config;
+      config.mBer = std::atof(argv[2]);
+      config.mBlocksPerLayer = argc > 3 ? std::atoll(argv[3]) : 1000;
+      config.mThreads = argc > 4 ? std::atoi(argv[4]) : 0;
+      config.mSeed = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 1;
+      const auto result = sim::RunImportance(code, config);
+      std::cout << "channel BER: " << config.mBer << "\tdecoder BER: " << result.mBer << " [" << result.mBerLow << ", "
+                << result.mBerHigh << "]\tblock error rate: " << result.mFer << " [" << result.mFerLow << ", "
+                << result.mFerHigh << "]\theavy words: 1.." << result.mMaxHeavy << "\tblocks: " << result.mBlocks << std::endl;
+      return 0;
+   }
+   if (mode == "sweep") {
+      sweep::StopRule rule;
+      std::vector<std::string> specs{"r5-hamming-c2"};
+      std::vector<double> bers{0.005, 0.01, 0.015, 0.02, 0.025, 0.03};
+      std::string csv_path;
+      std::string json_path;
+      for (int i = 2; i + 1 < argc; i += 2) {
+         const std::string key = argv[i];
+         const std::string value = argv[i + 1];
+         if (key == "--ber") {
+            bers.clear();
+            for (const auto& item : sweep::SplitList(value))
+               bers.push_back(std::atof(item.c_str()));
+         } else if (key == "--profiles") {
+            specs = sweep::SplitList(value);
+         } else if (key == "--target-errors") {
+            rule.mTargetBlockErrors = std::atoll(value.c_str());
+         } else if (key == "--width") {
+            rule.mTargetRelWidth = std::atof(value.c_str());
+         } else if (key == "--max-blocks") {
+            rule.mMaxBlocks = std::atoll(value.c_str());
+         } else if (key == "--threads") {
+            rule.mThreads = std::atoi(value.c_str());
+         } else if (key == "--seed") {
+            rule.mSeed = std::strtoull(value.c_str(), nullptr, 10);
+         } else if (key == "--csv") {
+            csv_path = value;
+         } else if (key == "--json") {
+            json_path = value;
+         } else {
+            std::cerr << "Unknown sweep option: " << key << "\n";
+            return 1;
+         }
+      }
+      std::vector<sweep::Profile> profiles;
+      for (const auto& spec : specs) {
+         sweep::Profile profile;
+         if (!sweep::ParseProfile(spec, profile)) {
+            std::cerr << "Unsupported profile: " << spec << " (expected r5|r6-hamming|golay-c0|c1|c2)\n";
+            return 1;
+         }
+         profiles.push_back(profile);
+      }
+      const auto points = sweep::Run(profiles, bers, rule, [](const sweep::Point& p) {
+         std::cerr << p.mProfile.mName << " @ " << p.mChannelBer << ": BER " << p.mResult.Ber() << ", FER " << p.mFer
+                   << " [" << p.mFerLow << ", " << p.mFerHigh << "], " << p.mResult.mBlocks << " blocks, " << p.mStop << std::endl;
+      });
+      if (!csv_path.empty()) {
+         std::ofstream out{csv_path};
+         sweep::WriteCsv(out, points);
+      }
+      if (!json_path.empty()) {
+         std::ofstream out{json_path};
+         sweep::WriteJson(out, points);
+      }
+      if (csv_path.empty() && json_path.empty())
+         sweep::WriteCsv(std::cout, points);
+      return 0;
+   }
+   if (mode == "analyze") {
+      sweep::Profile profile;
+      const std::string spec = argc > 2 ? argv[2] : "r5-hamming-c2";
+      if (!sweep::ParseProfile(spec, profile)) {
+         std::cerr << "Unsupported profile: " << spec << "\n";
+         return 1;
+      }
+      std::vector<double> bers{0.005, 0.01, 0.015, 0.02, 0.025, 0.03};
+      if (argc > 3) {
+         bers.clear();
+         for (const auto& item : sweep::SplitList(argv[3]))
+            bers.push_back(std::atof(item.c_str()));
+      }
+      sweep::WithCode(profile, [&](const auto& code) {
+         const auto spectrum = analysis::EnumerateErasures(code.mHammingCode.mHsys);
+         std::cout << "weight,patterns,unrecoverable\n";
+         for (int w = 0; w <= spectrum.mN; ++w)
+            std::cout << w << ',' << spectrum.mTotal[w] << ',' << spectrum.mUnrecoverable[w] << '\n';
+         std::cout << "channel_ber,word_failure,fer\n";
+         for (const double ber : bers) {
+            const double p_word = analysis::InnerWordFailure(ber, code.N, int(profile.mMode));
+            std::cout << ber << ',' << p_word << ',' << spectrum.FailureProbability(p_word) << '\n';
+         }
+      });
+      return 0;
+   }
+   if (mode == "analyze-inner") {
+      std::vector<double> bers{0.005, 0.01, 0.015, 0.02, 0.025, 0.03};
+      if (argc > 2) {
+         bers.clear();
+         for (const auto& item : sweep::SplitList(argv[2]))
+            bers.push_back(std::atof(item.c_str()));
+      }
+      const bool is_verified = argc > 3 && std::string(argv[3]) == "--verify";
+      std::cout << "inner_r,t,channel_ber,correct,detected,miscorrected,undetected\n";
+      for (const auto& spec : {"r5-hamming-c1", "r5-hamming-c2", "r6-hamming-c1", "r6-hamming-c2"}) {
+         sweep::Profile profile;
+         sweep::ParseProfile(spec, profile);
+         sweep::WithCode(profile, [&](const auto& code) {
+            const int t = int(profile.mMode);
+            const auto spectrum = analysis::RsSpectrum(code.N, code.R, t);
+            if (is_verified) {
+               const auto classes = analysis::ClassifySyndromes(code, profile.mMode);
+               const bool is_ok = classes.mCollisions == 0 && classes.mWrong == 0 && classes.mOutsideDecoded == 0 &&
+                                  classes.mCorrected1 + classes.mCorrected2 == spectrum.Patterns(1) + (t == 2 ? spectrum.Patterns(2) : 0);
+               std::cerr << "R = " << code.R << ", t = " << t << ": decoder " << (is_ok ? "matches" : "DOES NOT match")
+                         << " bounded-distance decoding\n";
+            }
+            for (const double ber : bers) {
+               const auto outcome = spectrum.ProbabilitiesForBer(ber);
+               std::cout << code.R << ',' << t << ',' << ber << ',' << outcome.mCorrect << ',' << outcome.mDetected << ','
+                         << outcome.mMiscorrected << ',' << outcome.mUndetected << '\n';
+            }
+         });
+      }
+      return 0;
+   }
+   if (mode == "verify-inner") {
+      const int r = argc > 2 ? std::atoi(argv[2]) : 5;
+      verify::Config config;
+      config.mCodewords = argc > 3 ? std::atoi(argv[3]) : 64;
+      config.mThreads = argc > 4 ? std::atoi(argv[4]) : 0;
+      sweep::Profile profile;
+      if (!sweep::ParseProfile("r" + std::to_string(r) + "-hamming-c2", profile)) {
+         std::cerr << "Unsupported RS parity count: " << r << "\n";
+         return 1;
+      }
+      int result = 0;
+      sweep::WithCode(profile, [&](const auto& code) {
+         using Code = std::decay_t<decltype(code)>;
+         const rsexh::DirectCorrector<Code> direct{code};
+         const auto report = verify::Run(code, [&code](std::vector<int>& v) { return code.Correct(v); },
+                                         [&direct](std::vector<int>& v) { return direct.Correct(v); }, config);
+         std::cout << "patterns: " << report.mPatterns << "\tmismatches: " << report.mMismatches << "\treference failures: "
+                   << report.mReferenceFailures << "\tpatterns/s: " << report.PatternsPerSecond() << "\tLUT ns: "
+                   << report.ReferenceNs() << "\tdirect ns: " << report.VariantNs() << std::endl;
+         for (const auto& m : report.mReported) {
+            std::cout << "codeword " << m.mCodeword << ": error " << m.mPos1 << '=' << m.mValue1 << ", " << m.mPos2 << '='
+                      << m.mValue2 << ", expected status " << int(m.mExpected) << ", got " << int(m.mActual) << '\n';
+         }
+         result = report.mMismatches == 0 && report.mReferenceFailures == 0 ? 0 : 2;
+      });
+      return result;
+   }
+   if (mode == "protect" || mode == "verify" || mode == "repair") {
+      if (argc < 3) {
+         std::cerr << "File name is required\n";
+         return 1;
+      }
+      const std::string sidecar = argc > 3 ? argv[3] : input + ".rsx";
+      if (mode == "protect")
+         return parity::Protect(input, sidecar);
+      if (mode == "verify")
+         return parity::Verify(input, sidecar);
+      return parity::Repair(input, sidecar);
+   }
+   std::cerr << "Usage:\n"
+             << "  " << argv[0] << "                          run tests and BER estimation\n"
+             << "  " << argv[0] << " encode [input] [output]  encode a stream ('-' or omitted: stdin/stdout)\n"
+             << "  " << argv[0] << " decode [input] [output]  decode a stream\n"
+             << "     encode/decode -i <depth> ...           interleave <depth> blocks against burst errors\n"
+             << "     encode/decode -t <threads> ...         coding threads (default: hardware threads)\n"
+             << "     decode --verify ...                    detect RS miscorrections by the outer code\n"
+             << "  " << argv[0] << " sim <ber> [blocks] [threads] [seed]  estimate decoder BER (deterministic per seed)\n"
+             << "  " << argv[0] << " sim-is <ber> [blocks per layer] [threads] [seed]  importance sampling with 95% intervals\n"
+             << "  " << argv[0] << " sweep [--ber list] [--profiles list] [--target-errors N] [--width w] [--max-blocks N]\n"
+             << "        [--threads N] [--seed N] [--csv file] [--json file]  BER/FER curves, profiles like r5-hamming-c2\n"
+             << "  " << argv[0] << " analyze [profile] [ber list]  exact erasure spectrum of the outer code and block error rate\n"
+             << "  " << argv[0] << " analyze-inner [ber list] [--verify]  RS decoding outcome probabilities for R = 5, 6\n"
+             << "  " << argv[0] << " verify-inner [R] [codewords] [threads]  all 1- and 2-error patterns: direct-indexed vs LUT decoder\n"
+             << "  " << argv[0] << " protect <file> [sidecar] write parity sidecar (default: <file>.rsx)\n"
+             << "  " << argv[0] << " verify <file> [sidecar]  check the file against the sidecar\n"
+             << "  " << argv[0] << " repair <file> [sidecar]  repair the file and the sidecar in place\n";
+   return 1;
+}
+
 int main( int argc, char* argv[] )
 {
+   if (argc > 1) {
+      return run_cli(argc, argv);
+   }
    test_golay_code(true);
    test_golay_code(false);
 
    test_ex_hamming_code(true);
    test_ex_hamming_code(false);
 
+   test_packet_fec(0.02);
+   test_packet_fec(0.10);
+
+   test_sliding_window(0.02);
+   test_sliding_window(0.10);
+   test_sliding_window(0.02, uint32_t(-2500)); // Переполнение номеров посреди потока.
+
+   test_fountain(100, 0.1);
+   test_fountain(2000, 0.3);
+
+   test_partial_decode(0);
+   test_partial_decode(1);
+   test_partial_decode(3);
+
+   test_large_outer_code(40);
+   test_large_outer_code(160);
+
+   test_iterative_decode(0.015, 1000);
+   test_iterative_decode(0.025, 1000);
+
+   test_miscorrection_detection(0.015, 2000);
+   test_miscorrection_detection(0.025, 1000);
+
+   test_adaptive_policy();
+
+   test_burst_interleaving(500);
+
+   test_stream(0, 1, 0.002);
+   test_stream(4, 3, 0.002);
+   test_stream(0, 2, 0.002, 9);
+   test_stream(4, 2, 0.002, 9);
+   test_stream(3, 1, 0.002, 0);
+   // Вход не кратен блоку: короткий последний блок (кадр 240) или последний кадр потока (концевой блок) уничтожен.
+   test_stream(0, 2, 0.002, -1, 240);
+   test_stream(0, 2, 0.002, -1, 242);
+   test_stream(4, 2, 0.002, -1, 240);
+   test_stream(3, 1, 0.002, -1, 240);
+   test_stream_miscorrections();
+   test_file_protection();
+
+   test_error_injection(0.005, 20000);
+   test_error_injection(1.e-5, 20000);
+
+   test_parallel_simulator(0.015, 1000);
+
+   test_channel_models();
+
+   test_importance_sampling(0.015, 100, 2000);
+   test_importance_sampling(0.002, 1000, 0);
+
+   test_sweep();
+
+   test_erasure_analysis(0.02, 512);
+
+   test_inner_spectrum(0.1, 100000);
+
+   test_inner_exhaustive(2);
+   test_telemetry(0.02, 2000);
+
+   test_wide_symbols(2);
+   test_wide_symbols(3);
+
+   static hamming::HammingExtended<int, 6, 9> ex_hamming;
+   test_static_code<hamming::StaticExtendedHamming<int, 9>>("(32, 26)", ex_hamming);
+   static hamming::HammingExtended<int, 11, 9> golay{hamming::ToMatrix(hamming::kGolayParityMatrix), 7};
+   test_static_code<hamming::StaticGolay<int, 9>>("Golay (23, 12)", golay);
+
    // Channel BER : Decoder BER
    
    // Case A.
@@ -514,16 +1871,23 @@ int main( int argc, char* argv[] )
 
    const double ber = 0.015;
    double output_ber = 0;
+   static rsexh::RsExh code;
+   code.mHammingCode.SwitchToSystematic(false);
+   sim::Config config;
+   config.mBer = ber;
+   config.mSeed = seed;
+   config.mBlocks = 10000 * std::max(1u, std::thread::hardware_concurrency());
+   sim::Result total;
    for (double counter = 1;; counter++) {
       double prev_ber = output_ber;
-      auto out_ber = measure_ber(ber, 10000);
-      if (out_ber == -1.) {
-         return -1;
-      }
-      output_ber += (out_ber - output_ber) / counter;
+      const auto result = sim::Run(code, config);
+      config.mFirstBlock += config.mBlocks;
+      total.mBits += result.mBits;
+      total.mBitErrors += result.mBitErrors;
+      output_ber = total.Ber();
       const double rel_error = output_ber != 0. ? std::abs(prev_ber - output_ber) / output_ber : 1.;
-      std::cout << "decoder BER: " << output_ber << "\tcounter: " << counter << "\tchannel BER: " << ber << "\t(sample ber = " << out_ber << ")" << std::endl;
-      if (out_ber > 0 && rel_error < 1.e-4) {
+      std::cout << "decoder BER: " << output_ber << "\tcounter: " << counter << "\tchannel BER: " << ber << "\t(sample ber = " << result.Ber() << ")" << std::endl;
+      if (result.mBitErrors > 0 && rel_error < 1.e-4) {
          break;
       }
    }
@@ -0,0 +1,359 @@
+/**
+ * Пакетная помехоустойчивость: внешний код над датаграммами.
+ * Символ внешнего кода - целый пакет, K пакетов приложения образуют поколение,
+ * к которому добавляются R восстанавливающих (repair) пакетов.
+ */
+
+#pragma once
+
+#include <cstdint>    // uint8_t
+#include <cstring>    // std::memcpy
+#include <algorithm>  // std::min
+#include <array>      // std::array
+#include <vector>     // std::vector
+#include <random>     // std::mt19937
+#include <functional> // std::function
+#include "hamming.hpp"
+
+namespace fec {
+
+    /**
+     * Заголовок пакета: номер поколения (4 байта), индекс символа в поколении (1 байт),
+     * количество пакетов приложения в поколении (1 байт). Пакет приложения отправляется до того, как известен
+     * размер поколения, и несет K; восстанавливающие пакеты несут фактическое количество (меньше K у последнего
+     * неполного поколения). Декодер берет наименьшее из принятых.
+     */
+    inline constexpr int kHeaderBytes = 6;
+
+    /**
+     * Длина пакета приложения хранится в начале символа (2 байта), чтобы восстановленный пакет знал свою длину.
+     */
+    inline constexpr int kLengthBytes = 2;
+
+    struct PacketHeader
+    {
+        uint32_t mGeneration = 0;
+        int mIndex = 0;
+        int mSources = 0;
+
+        void Write(uint8_t* p) const
+        {
+            for (int i = 0; i < 4; ++i)
+                p[i] = uint8_t(mGeneration >> (8 * i));
+            p[4] = uint8_t(mIndex);
+            p[5] = uint8_t(mSources);
+        }
+
+        void Read(const uint8_t* p)
+        {
+            mGeneration = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+            mIndex = p[4];
+            mSources = p[5];
+        }
+    };
+
+    /**
+     * Кодер. Восстанавливающие пакеты накапливаются по мере поступления пакетов приложения (XOR по строкам
+     * систематической проверочной матрицы), поэтому сами пакеты не хранятся. Память выделяется один раз.
+     * R - количество восстанавливающих пакетов, MaxPacket - наибольшая длина пакета приложения.
+     */
+    template <int R, int MaxPacket>
+    class Encoder
+    {
+    public:
+        static constexpr int SymbolBytes = MaxPacket + kLengthBytes;
+        using Code = hamming::HammingExtended< uint8_t, R, SymbolBytes >;
+        using Send = std::function<void(const uint8_t*, int)>;
+
+        explicit Encoder(Send send, const hamming::Matrix<int>& H = {}, int code_distance = -1)
+            : mCode{H, code_distance}
+            , mSend{std::move(send)}
+            , mRepair(R)
+            , mPacket(kHeaderBytes + SymbolBytes)
+        {
+            assert(mCode.K <= 255 && mCode.N <= 256);
+        }
+
+        int K() const { return mCode.K; }
+
+        /**
+         * Отправить пакет приложения. По заполнении поколения отправляются восстанавливающие пакеты.
+         */
+        void Add(const uint8_t* data, int length)
+        {
+            assert(length >= 0 && length <= MaxPacket);
+            uint8_t* symbol = mPacket.data() + kHeaderBytes;
+            PacketHeader{mGeneration, mSources, mCode.K}.Write(mPacket.data());
+            symbol[0] = uint8_t(length);
+            symbol[1] = uint8_t(length >> 8);
+            std::memcpy(symbol + kLengthBytes, data, length);
+            mSend(mPacket.data(), kHeaderBytes + kLengthBytes + length);
+            // Хвост символа - нули, его вклад в XOR нулевой.
+            for (int j = 0; j < R; ++j) {
+                if (mCode.mHsys.at(j).at(mSources) == 0)
+                    continue;
+                hamming::XorBytes(mRepair[j].mSymbol.data(), symbol, kLengthBytes + length);
+            }
+            if (++mSources == mCode.K) {
+                Flush();
+            }
+        }
+
+        /**
+         * Завершить текущее поколение (в том числе неполное) и отправить восстанавливающие пакеты.
+         */
+        void Flush()
+        {
+            if (mSources == 0) {
+                return;
+            }
+            for (int j = 0; j < R; ++j) {
+                PacketHeader{mGeneration, mCode.K + j, mSources}.Write(mPacket.data());
+                std::memcpy(mPacket.data() + kHeaderBytes, mRepair[j].mSymbol.data(), SymbolBytes);
+                mSend(mPacket.data(), kHeaderBytes + SymbolBytes);
+                mRepair[j].mSymbol.fill(0);
+            }
+            mSources = 0;
+            mGeneration++;
+        }
+
+    private:
+        Code mCode;
+        Send mSend;
+        hamming::CodeWord< uint8_t, SymbolBytes > mRepair;
+        std::vector<uint8_t> mPacket;
+        uint32_t mGeneration = 0;
+        int mSources = 0;
+    };
+
+    /**
+     * Статистика декодера.
+     */
+    struct DecoderStats
+    {
+        long long mReceived = 0;   // Принятых пакетов (всех).
+        long long mDelivered = 0;  // Доставленных пакетов приложения, включая восстановленные.
+        long long mRecovered = 0;  // Восстановленных пакетов приложения.
+        long long mLost = 0;       // Пакетов приложения, не восстановленных к моменту вытеснения поколения.
+        long long mStale = 0;      // Пакетов устаревших поколений.
+    };
+
+    /**
+     * Декодер. Пул из Slots поколений с заранее выделенными буферами символов; поколение
+     * вытесняется более новым с тем же номером слота. Пакеты приложения доставляются сразу по приему,
+     * потерянные - как только принятых символов достаточно для восстановления стираний.
+     */
+    template <int R, int MaxPacket, int Slots = 4>
+    class Decoder
+    {
+    public:
+        static constexpr int SymbolBytes = MaxPacket + kLengthBytes;
+        using Code = hamming::HammingExtended< uint8_t, R, SymbolBytes >;
+        using Deliver = std::function<void(uint32_t generation, int index, const uint8_t* data, int length)>;
+
+        explicit Decoder(Deliver deliver, const hamming::Matrix<int>& H = {}, int code_distance = -1)
+            : mCode{H, code_distance}
+            , mDeliver{std::move(deliver)}
+        {
+            for (auto& slot : mSlots) {
+                slot.mSymbols.resize(mCode.N);
+                slot.mWork.reserve(mCode.N);
+                slot.mHave.resize(mCode.N);
+                slot.mDelivered.resize(mCode.K);
+            }
+        }
+
+        /**
+         * Принять пакет из канала.
+         */
+        void Receive(const uint8_t* packet, int length)
+        {
+            if (length < kHeaderBytes + kLengthBytes) {
+                return;
+            }
+            PacketHeader header;
+            header.Read(packet);
+            if (header.mIndex >= mCode.N || header.mSources > mCode.K || header.mSources == 0) {
+                return;
+            }
+            mStats.mReceived++;
+            auto& slot = mSlots[header.mGeneration % Slots];
+            if (!slot.mIsUsed || int32_t(header.mGeneration - slot.mGeneration) > 0) {
+                Evict(slot);
+                Reset(slot, header);
+            } else if (header.mGeneration != slot.mGeneration) {
+                mStats.mStale++;
+                return;
+            }
+            if (header.mSources < slot.mSources) {
+                Shrink(slot, header.mSources);
+            }
+            if (slot.mHave[header.mIndex] || slot.mIsComplete) {
+                return;
+            }
+            const int symbol_bytes = std::min(length - kHeaderBytes, SymbolBytes);
+            auto& symbol = slot.mSymbols[header.mIndex];
+            std::memcpy(symbol.mSymbol.data(), packet + kHeaderBytes, symbol_bytes);
+            std::fill(symbol.mSymbol.begin() + symbol_bytes, symbol.mSymbol.end(), 0);
+            symbol.mStatus = hamming::SymbolStatus::Normal;
+            slot.mHave[header.mIndex] = true;
+            slot.mCount++;
+            if (header.mIndex < slot.mSources) {
+                DeliverSymbol(slot, header.mIndex, false);
+            }
+            TryRecover(slot);
+        }
+
+        /**
+         * Вытеснить все поколения (конец потока): недоставленные пакеты считаются потерянными.
+         */
+        void Flush()
+        {
+            for (auto& slot : mSlots) {
+                Evict(slot);
+                slot.mIsUsed = false;
+            }
+        }
+
+        const DecoderStats& Stats() const { return mStats; }
+
+    private:
+        struct Slot
+        {
+            bool mIsUsed = false;
+            bool mIsComplete = false;
+            uint32_t mGeneration = 0;
+            int mSources = 0;
+            int mCount = 0;
+            int mDeliveredCount = 0;
+            hamming::CodeWord< uint8_t, SymbolBytes > mSymbols;
+            hamming::CodeWord< uint8_t, SymbolBytes > mWork;
+            std::vector<bool> mHave;
+            std::vector<bool> mDelivered;
+        };
+
+        void Reset(Slot& slot, const PacketHeader& header)
+        {
+            slot.mIsUsed = true;
+            slot.mIsComplete = false;
+            slot.mGeneration = header.mGeneration;
+            slot.mSources = mCode.K;
+            slot.mCount = 0;
+            slot.mDeliveredCount = 0;
+            std::fill(slot.mHave.begin(), slot.mHave.end(), false);
+            std::fill(slot.mDelivered.begin(), slot.mDelivered.end(), false);
+            Shrink(slot, header.mSources);
+        }
+
+        /**
+         * Уменьшить размер поколения до sources: отсутствующие пакеты неполного поколения - известные нулевые символы.
+         */
+        void Shrink(Slot& slot, int sources)
+        {
+            for (int i = sources; i < slot.mSources; ++i) {
+                slot.mCount -= slot.mHave[i];
+                slot.mSymbols[i].mSymbol.fill(0);
+                slot.mSymbols[i].mStatus = hamming::SymbolStatus::Normal;
+                slot.mHave[i] = true;
+            }
+            slot.mSources = sources;
+        }
+
+        void Evict(Slot& slot)
+        {
+            if (slot.mIsUsed) {
+                mStats.mLost += slot.mSources - slot.mDeliveredCount;
+            }
+        }
+
+        void DeliverSymbol(Slot& slot, int index, bool recovered)
+        {
+            if (slot.mDelivered[index]) {
+                return;
+            }
+            const auto& symbol = slot.mSymbols[index].mSymbol;
+            const int length = std::min<int>(symbol[0] | (symbol[1] << 8), MaxPacket);
+            slot.mDelivered[index] = true;
+            slot.mDeliveredCount++;
+            mStats.mDelivered++;
+            mStats.mRecovered += recovered;
+            mDeliver(slot.mGeneration, index, symbol.data() + kLengthBytes, length);
+        }
+
+        /**
+         * Восстановить потерянные пакеты, если стираний не больше R.
+         */
+        void TryRecover(Slot& slot)
+        {
+            if (slot.mDeliveredCount == slot.mSources) {
+                slot.mIsComplete = true;
+                return;
+            }
+            const int known = slot.mCount + (mCode.K - slot.mSources);
+            if (mCode.N - known > R) {
+                return;
+            }
+            slot.mWork.assign(slot.mSymbols.begin(), slot.mSymbols.end());
+            for (int i = 0; i < mCode.N; ++i) {
+                if (!slot.mHave[i])
+                    slot.mWork[i].mStatus = hamming::SymbolStatus::Erased;
+            }
+            int erased;
+            if (!mCode.Decode(slot.mWork, erased) || !mCode.mIsSolved) {
+                return;
+            }
+            for (int i = 0; i < slot.mSources; ++i) {
+                if (slot.mHave[i])
+                    continue;
+                slot.mSymbols[i] = slot.mWork[i];
+                slot.mHave[i] = true;
+                DeliverSymbol(slot, i, true);
+            }
+            slot.mIsComplete = true;
+        }
+
+        Code mCode;
+        Deliver mDeliver;
+        std::array<Slot, Slots> mSlots;
+        DecoderStats mStats;
+    };
+
+    /**
+     * Локальный канал с потерями для тестов: пакет теряется с заданной вероятностью,
+     * иначе сразу передается получателю. Детерминирован при заданном зерне.
+     */
+    class LossyLoopback
+    {
+    public:
+        using Receive = std::function<void(const uint8_t*, int)>;
+
+        LossyLoopback(double loss_probability, uint32_t seed, Receive receive)
+            : mLoss{loss_probability}
+            , mUrbg{seed}
+            , mReceive{std::move(receive)}
+        {
+        }
+
+        void Send(const uint8_t* packet, int length)
+        {
+            mSent++;
+            if (mDistr(mUrbg) < mLoss) {
+                mDropped++;
+                return;
+            }
+            mReceive(packet, length);
+        }
+
+        long long Sent() const { return mSent; }
+        long long Dropped() const { return mDropped; }
+
+    private:
+        double mLoss;
+        std::mt19937 mUrbg;
+        std::uniform_real_distribution<double> mDistr{0., 1.};
+        Receive mReceive;
+        long long mSent = 0;
+        long long mDropped = 0;
+    };
+
+} // namespace fec
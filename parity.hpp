@@ -0,0 +1,581 @@
+/**
+ * Защита файлов каскадным кодом: проверочный файл-спутник (sidecar), проверка и восстановление.
+ * Файл данных отображается в память (mmap) и не копируется: проверочные символы считаются прямо по отображению.
+ */
+
+#pragma once
+
+#include <cstdint>  // uint8_t
+#include <cstring>  // std::memcmp
+#include <string>   // std::string
+#include <vector>   // std::vector
+#include <atomic>   // std::atomic
+#include <thread>   // std::thread
+#include <algorithm> // std::find
+#include <iostream> // std::cerr
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "rsexh.hpp"
+
+namespace parity {
+
+    /**
+     * Регион - символ внешнего кода. Внутри региона каждые 5 байт (K = 10 полубайт) защищены
+     * систематическим кодом РС, проверочные полубайты которого хранятся в файле-спутнике.
+     */
+    inline constexpr int kRegionBytes = 4000;
+    inline constexpr int kWordBytes = rsexh::RsExh::K / 2;
+    inline constexpr int kWordsPerRegion = kRegionBytes / kWordBytes;
+    inline constexpr int kInnerParityBytes = kWordsPerRegion * rsexh::RsExh::R / 2;
+    static_assert(rsexh::RsExh::K % 2 == 0 && kRegionBytes % kWordBytes == 0);
+    static_assert((kWordsPerRegion * rsexh::RsExh::R) % 2 == 0);
+
+    /**
+     * Внешний код над регионами: символ - весь регион.
+     */
+    using OuterCode = hamming::HammingExtended< uint8_t, rsexh::RsExh::R2, kRegionBytes >;
+
+    /**
+     * Заголовок файла-спутника.
+     */
+    struct Header
+    {
+        char mMagic[8] = {'R', 'S', 'X', 'P', 'A', 'R', '0', '1'};
+        uint64_t mFileSize = 0;
+        uint32_t mRegionBytes = kRegionBytes;
+        uint32_t mK = 0; // Информационных регионов в группе.
+        uint32_t mR = 0; // Проверочных регионов в группе.
+        uint32_t mReserved = 0;
+        uint64_t mGroups = 0;
+    };
+
+    /**
+     * Разметка файла-спутника: заголовок, затем группы одинакового размера.
+     * Группа: проверочные полубайты РС для K регионов данных, затем R проверочных регионов
+     * внешнего кода вместе с их собственными проверочными полубайтами РС.
+     */
+    struct Layout
+    {
+        Layout(uint64_t file_size, int k, int r)
+            : mFileSize{file_size}, mK{k}, mR{r}
+        {
+            const uint64_t regions = (file_size + kRegionBytes - 1) / kRegionBytes;
+            mGroups = (regions + k - 1) / k;
+            mGroupBytes = uint64_t(k) * kInnerParityBytes + uint64_t(r) * (kRegionBytes + kInnerParityBytes);
+        }
+
+        uint64_t SidecarBytes() const
+        {
+            return sizeof(Header) + mGroups * mGroupBytes;
+        }
+
+        uint64_t GroupOffset(uint64_t g) const
+        {
+            return sizeof(Header) + g * mGroupBytes;
+        }
+
+        /**
+         * Проверочные полубайты РС региона i группы (i < K - данные, иначе проверочный регион).
+         */
+        uint64_t InnerParityOffset(uint64_t g, int i) const
+        {
+            if (i < mK) {
+                return GroupOffset(g) + uint64_t(i) * kInnerParityBytes;
+            }
+            return GroupOffset(g) + uint64_t(mK) * kInnerParityBytes
+                 + uint64_t(i - mK) * (kRegionBytes + kInnerParityBytes) + kRegionBytes;
+        }
+
+        /**
+         * Проверочный регион j группы.
+         */
+        uint64_t OuterParityOffset(uint64_t g, int j) const
+        {
+            return GroupOffset(g) + uint64_t(mK) * kInnerParityBytes + uint64_t(j) * (kRegionBytes + kInnerParityBytes);
+        }
+
+        uint64_t mFileSize;
+        int mK;
+        int mR;
+        uint64_t mGroups = 0;
+        uint64_t mGroupBytes = 0;
+    };
+
+    /**
+     * Отображение файла в память.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string& path, bool writable, uint64_t resize_to = uint64_t(-1))
+        {
+            const bool create = resize_to != uint64_t(-1);
+            mFd = ::open(path.c_str(), writable ? (create ? (O_RDWR | O_CREAT) : O_RDWR) : O_RDONLY, 0644);
+            if (mFd < 0) {
+                return;
+            }
+            if (create && ::ftruncate(mFd, resize_to) != 0) {
+                return;
+            }
+            struct stat st{};
+            if (::fstat(mFd, &st) != 0) {
+                return;
+            }
+            mSize = st.st_size;
+            mIsOk = true;
+            if (mSize == 0) {
+                return;
+            }
+            void* ptr = ::mmap(nullptr, mSize, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, mFd, 0);
+            if (ptr == MAP_FAILED) {
+                mIsOk = false;
+                return;
+            }
+            mData = static_cast< uint8_t* >(ptr);
+            ::madvise(mData, mSize, MADV_SEQUENTIAL);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+            if (mData) {
+                ::munmap(mData, mSize);
+            }
+            if (mFd >= 0) {
+                ::close(mFd);
+            }
+        }
+
+        bool IsOk() const { return mIsOk; }
+        uint8_t* Data() const { return mData; }
+        uint64_t Size() const { return mSize; }
+
+    private:
+        int mFd = -1;
+        uint8_t* mData = nullptr;
+        uint64_t mSize = 0;
+        bool mIsOk = false;
+    };
+
+    inline int GetNibble(const uint8_t* bytes, int idx)
+    {
+        return (idx % 2 == 0) ? (bytes[idx / 2] >> 4) : (bytes[idx / 2] & 15);
+    }
+
+    inline void SetNibble(uint8_t* bytes, int idx, int value)
+    {
+        bytes[idx / 2] = (idx % 2 == 0) ? ((bytes[idx / 2] & 0x0F) | (value << 4)) : ((bytes[idx / 2] & 0xF0) | value);
+    }
+
+    /**
+     * Указатель на регион в отображении и его фактическая длина (хвост файла дополняется нулями виртуально).
+     */
+    struct RegionView
+    {
+        const uint8_t* mData = nullptr;
+        int mBytes = 0;
+    };
+
+    /**
+     * Собрать кодовое слово РС номер w региона: K информационных полубайт.
+     */
+    inline void LoadWord(const RegionView& region, int w, int* word)
+    {
+        const int offset = w * kWordBytes;
+        for (int j = 0; j < rsexh::RsExh::K; ++j) {
+            const int byte = offset + j / 2;
+            const int value = byte < region.mBytes ? region.mData[byte] : 0;
+            word[j] = (j % 2 == 0) ? (value >> 4) : (value & 15);
+        }
+    }
+
+    /**
+     * Вычислить проверочные полубайты РС для всего региона.
+     */
+    inline void ComputeInnerParity(const rsexh::RsExh& code, const RegionView& region, uint8_t* parity)
+    {
+        constexpr int R = rsexh::RsExh::R;
+        int word[rsexh::RsExh::K];
+        int p[R];
+        for (int w = 0; w < kWordsPerRegion; ++w) {
+            LoadWord(region, w, word);
+            code.EncodeSystematic(word, p);
+            for (int t = 0; t < R; ++t) {
+                SetNibble(parity, w * R + t, p[t]);
+            }
+        }
+    }
+
+    /**
+     * Проверить регион по проверочным полубайтам РС; при необходимости исправить его копию.
+     * @param corrected Если не nullptr - сюда пишется исправленная копия региона (kRegionBytes байт).
+     * @param corrected_words Количество исправленных слов РС.
+     * @return false, если хотя бы одно слово РС неисправимо (регион стерт).
+     */
+    inline bool CheckRegion(const rsexh::RsExh& code, const RegionView& region, const uint8_t* parity,
+                            uint8_t* corrected, int& corrected_words)
+    {
+        constexpr int R = rsexh::RsExh::R;
+        constexpr int K = rsexh::RsExh::K;
+        corrected_words = 0;
+        bool is_ok = true;
+        int word[K];
+        int p[R];
+        std::vector<int> v(rsexh::RsExh::N);
+        if (corrected) {
+            std::memset(corrected, 0, kRegionBytes);
+            if (region.mBytes > 0)
+                std::memcpy(corrected, region.mData, region.mBytes);
+        }
+        for (int w = 0; w < kWordsPerRegion; ++w) {
+            LoadWord(region, w, word);
+            code.EncodeSystematic(word, p);
+            bool same = true;
+            for (int t = 0; t < R; ++t) {
+                same &= p[t] == GetNibble(parity, w * R + t);
+            }
+            if (same) {
+                continue;
+            }
+            for (int j = 0; j < K; ++j)
+                v[j] = word[j];
+            for (int t = 0; t < R; ++t)
+                v[K + t] = GetNibble(parity, w * R + t);
+            if (code.Correct(v) == rsexh::InnerStatus::Failed) {
+                is_ok = false;
+                continue;
+            }
+            corrected_words++;
+            if (corrected) {
+                for (int j = 0; j < K; ++j)
+                    SetNibble(corrected + w * kWordBytes, j, v[j]);
+            }
+        }
+        return is_ok;
+    }
+
+    /**
+     * Выполнить fn(g) для всех групп в threads потоках.
+     */
+    template <typename Fn>
+    inline void ForEachGroup(uint64_t groups, int threads, Fn&& fn)
+    {
+        std::atomic<uint64_t> next{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (uint64_t g = next++; g < groups; g = next++) {
+                    fn(g);
+                }
+            });
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    inline int DefaultThreads()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Вид региона данных i группы g в отображении файла.
+     */
+    inline RegionView DataRegion(const MappedFile& file, uint64_t g, int k, int i)
+    {
+        const uint64_t offset = (g * k + i) * uint64_t(kRegionBytes);
+        if (offset >= file.Size()) {
+            return {};
+        }
+        return {file.Data() + offset, int(std::min<uint64_t>(kRegionBytes, file.Size() - offset))};
+    }
+
+    /**
+     * Открыть файл-спутник и проверить его заголовок.
+     */
+    inline bool CheckHeader(const MappedFile& sidecar, const MappedFile& file, Layout& layout)
+    {
+        if (!sidecar.IsOk() || sidecar.Size() < sizeof(Header)) {
+            std::cerr << "Cannot open sidecar file\n";
+            return false;
+        }
+        Header header;
+        std::memcpy(&header, sidecar.Data(), sizeof(Header));
+        const Header expected;
+        if (std::memcmp(header.mMagic, expected.mMagic, sizeof(header.mMagic)) != 0 || header.mRegionBytes != kRegionBytes) {
+            std::cerr << "Sidecar format is not supported\n";
+            return false;
+        }
+        if (header.mFileSize != file.Size()) {
+            std::cerr << "File size differs from the protected one: " << file.Size() << " vs " << header.mFileSize << '\n';
+            return false;
+        }
+        layout = Layout{header.mFileSize, int(header.mK), int(header.mR)};
+        if (layout.SidecarBytes() != sidecar.Size()) {
+            std::cerr << "Sidecar file is truncated\n";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Сформировать файл-спутник для файла.
+     */
+    inline int Protect(const std::string& path, const std::string& sidecar_path, int threads = DefaultThreads())
+    {
+        rsexh::RsExh code;
+        const OuterCode outer;
+        MappedFile file{path, false};
+        if (!file.IsOk()) {
+            std::cerr << "Cannot open " << path << '\n';
+            return 1;
+        }
+        const Layout layout{file.Size(), outer.K, outer.N - outer.K};
+        MappedFile sidecar{sidecar_path, true, layout.SidecarBytes()};
+        if (!sidecar.IsOk()) {
+            std::cerr << "Cannot create " << sidecar_path << '\n';
+            return 1;
+        }
+        Header header;
+        header.mFileSize = layout.mFileSize;
+        header.mK = layout.mK;
+        header.mR = layout.mR;
+        header.mGroups = layout.mGroups;
+        std::memcpy(sidecar.Data(), &header, sizeof(Header));
+        ForEachGroup(layout.mGroups, threads, [&](uint64_t g) {
+            for (int j = 0; j < layout.mR; ++j) {
+                std::memset(sidecar.Data() + layout.OuterParityOffset(g, j), 0, kRegionBytes);
+            }
+            for (int i = 0; i < layout.mK; ++i) {
+                const auto region = DataRegion(file, g, layout.mK, i);
+                ComputeInnerParity(code, region, sidecar.Data() + layout.InnerParityOffset(g, i));
+                // Внешний код: проверочный регион j - XOR регионов данных по строке систематической матрицы.
+                for (int j = 0; j < layout.mR; ++j) {
+                    if (outer.mHsys.at(j).at(i) == 0)
+                        continue;
+                    hamming::XorBytes(sidecar.Data() + layout.OuterParityOffset(g, j), region.mData, region.mBytes);
+                }
+            }
+            for (int j = 0; j < layout.mR; ++j) {
+                const RegionView region{sidecar.Data() + layout.OuterParityOffset(g, j), kRegionBytes};
+                ComputeInnerParity(code, region, sidecar.Data() + layout.InnerParityOffset(g, layout.mK + j));
+            }
+        });
+        std::cerr << "Protected " << layout.mFileSize << " bytes in " << layout.mGroups << " groups\n";
+        return 0;
+    }
+
+    /**
+     * Итоги проверки/восстановления.
+     */
+    struct Report
+    {
+        std::atomic<long long> mCorrectedWords{0}; // Слов РС с исправимыми ошибками.
+        std::atomic<long long> mErasedRegions{0};  // Регионов с неисправимыми словами РС.
+        std::atomic<long long> mMiscorrectedRegions{0}; // Регионов с ложными исправлениями РС (найдены внешним кодом).
+        std::atomic<long long> mRepairedRegions{0};
+        std::atomic<long long> mLostGroups{0};     // Групп, которые не удалось восстановить.
+    };
+
+    /**
+     * Декодировать группу: коррекция РС внутри регионов, затем внешний код с проверкой согласованности
+     * (как RsExhT::DecodeBlockVerified). Ложно исправленное слово РС оставляет регион нестертым;
+     * это обнаруживается сверкой перекодированной группы со всеми нестертыми регионами, а виновные регионы
+     * ищутся пробным стиранием: по одному, затем парами среди исправленных, в пределах оставшейся избыточности.
+     * Принимается только единственное согласованное решение.
+     * Исправленные слова учитываются лишь в принятых регионах: слова стертого региона пересчитываются целиком.
+     * @param parities Проверочные полубайты РС регионов.
+     * @param group Восстановленная группа (все регионы) - только если есть что перезаписывать.
+     * @param changed Регионы, отличающиеся от записанных.
+     * @return false - группу восстановить не удалось.
+     */
+    inline bool DecodeGroup(const rsexh::RsExh& code, const std::vector<RegionView>& views,
+                            const std::vector<const uint8_t*>& parities, Report& report,
+                            hamming::CodeWord< uint8_t, kRegionBytes >& group, std::vector<bool>& changed)
+    {
+        const int n = views.size();
+        changed.assign(n, false);
+        // Быстрый проход без копирования: группа без повреждений не трогается.
+        bool damaged = false;
+        for (int i = 0; i < n && !damaged; ++i) {
+            int corrected_words;
+            damaged |= !CheckRegion(code, views[i], parities[i], nullptr, corrected_words) || corrected_words > 0;
+        }
+        if (!damaged) {
+            return true;
+        }
+        OuterCode outer;
+        hamming::CodeWord< uint8_t, kRegionBytes > v(n);
+        std::vector<int> corrected_words(n);
+        int erased = 0;
+        for (int i = 0; i < n; ++i) {
+            const bool is_ok = CheckRegion(code, views[i], parities[i], v[i].mSymbol.data(), corrected_words[i]);
+            v[i].mStatus = is_ok ? hamming::SymbolStatus::Normal : hamming::SymbolStatus::Erased;
+            changed[i] = !is_ok || corrected_words[i] > 0;
+            erased += !is_ok;
+        }
+        report.mErasedRegions += erased;
+        // Стереть регионы ids и декодировать; true - решение согласовано со всеми оставшимися регионами.
+        hamming::CodeWord< uint8_t, kRegionBytes > result;
+        auto try_erase = [&](std::initializer_list<int> ids) {
+            result = v;
+            for (const int i : ids)
+                result[i].mStatus = hamming::SymbolStatus::Erased;
+            int result_erased;
+            if (!outer.Decode(result, result_erased) || !outer.mIsSolved) {
+                return false;
+            }
+            result = outer.Encode(result);
+            for (int i = 0; i < n; ++i) {
+                if (v[i].mStatus == hamming::SymbolStatus::Normal && std::find(ids.begin(), ids.end(), i) == ids.end()
+                    && result[i].mSymbol != v[i].mSymbol)
+                    return false;
+            }
+            return true;
+        };
+        std::vector<int> miscorrected;
+        if (!try_erase({})) {
+            std::vector<int> suspects;
+            std::vector<int> corrected;
+            for (int i = 0; i < n; ++i) {
+                if (v[i].mStatus != hamming::SymbolStatus::Normal)
+                    continue;
+                suspects.push_back(i);
+                if (corrected_words[i] > 0)
+                    corrected.push_back(i);
+            }
+            const int budget = outer.D - 2 - erased; // Стираний еще можно добавить, сохранив обнаружение.
+            std::vector<std::vector<int>> found;
+            hamming::CodeWord< uint8_t, kRegionBytes > found_result;
+            auto accept = [&](std::vector<int> ids) {
+                found.push_back(std::move(ids));
+                found_result = result;
+            };
+            if (budget >= 1) {
+                for (const int i : suspects) {
+                    if (try_erase({i}))
+                        accept({i});
+                }
+            }
+            if (found.empty() && budget >= 2) {
+                for (std::size_t x = 0; x < corrected.size(); ++x) {
+                    for (std::size_t y = x + 1; y < corrected.size(); ++y) {
+                        if (try_erase({corrected[x], corrected[y]}))
+                            accept({corrected[x], corrected[y]});
+                    }
+                }
+            }
+            if (found.size() != 1) {
+                return false;
+            }
+            miscorrected = std::move(found.front());
+            result = std::move(found_result);
+        }
+        for (int i = 0; i < n; ++i) {
+            const bool is_miscorrected = std::find(miscorrected.begin(), miscorrected.end(), i) != miscorrected.end();
+            if (is_miscorrected) {
+                changed[i] = true;
+                report.mMiscorrectedRegions++;
+            } else if (v[i].mStatus == hamming::SymbolStatus::Normal) {
+                report.mCorrectedWords += corrected_words[i];
+            }
+        }
+        group = std::move(result);
+        return true;
+    }
+
+    /**
+     * Проверить файл по файлу-спутнику. Код возврата: 0 - повреждений нет, 2 - повреждения есть.
+     */
+    inline int Verify(const std::string& path, const std::string& sidecar_path, int threads = DefaultThreads())
+    {
+        rsexh::RsExh code;
+        MappedFile file{path, false};
+        MappedFile sidecar{sidecar_path, false};
+        Layout layout{0, 1, 1};
+        if (!file.IsOk() || !CheckHeader(sidecar, file, layout)) {
+            return 1;
+        }
+        Report report;
+        ForEachGroup(layout.mGroups, threads, [&](uint64_t g) {
+            const int n = layout.mK + layout.mR;
+            std::vector<RegionView> views(n);
+            std::vector<const uint8_t*> parities(n);
+            for (int i = 0; i < n; ++i) {
+                views[i] = i < layout.mK ? DataRegion(file, g, layout.mK, i)
+                    : RegionView{sidecar.Data() + layout.OuterParityOffset(g, i - layout.mK), kRegionBytes};
+                parities[i] = sidecar.Data() + layout.InnerParityOffset(g, i);
+            }
+            hamming::CodeWord< uint8_t, kRegionBytes > group;
+            std::vector<bool> changed;
+            report.mLostGroups += !DecodeGroup(code, views, parities, report, group, changed);
+        });
+        std::cerr << "Damaged RS words (correctable): " << report.mCorrectedWords
+                  << ", erased regions: " << report.mErasedRegions
+                  << ", miscorrected regions: " << report.mMiscorrectedRegions
+                  << ", unrecoverable groups: " << report.mLostGroups << '\n';
+        return (report.mCorrectedWords == 0 && report.mErasedRegions == 0 && report.mMiscorrectedRegions == 0
+                && report.mLostGroups == 0) ? 0 : 2;
+    }
+
+    /**
+     * Восстановить файл и файл-спутник. Коррекция РС внутри регионов, затем восстановление
+     * стертых регионов внешним кодом. Записываются только измененные регионы.
+     * Код возврата: 0 - все восстановлено, 2 - часть групп восстановить не удалось.
+     */
+    inline int Repair(const std::string& path, const std::string& sidecar_path, int threads = DefaultThreads())
+    {
+        rsexh::RsExh code;
+        MappedFile file{path, true};
+        MappedFile sidecar{sidecar_path, true};
+        Layout layout{0, 1, 1};
+        if (!file.IsOk() || !CheckHeader(sidecar, file, layout)) {
+            return 1;
+        }
+        Report report;
+        ForEachGroup(layout.mGroups, threads, [&](uint64_t g) {
+            const int n = layout.mK + layout.mR;
+            std::vector<RegionView> views(n);
+            std::vector<uint8_t*> targets(n);
+            std::vector<const uint8_t*> parities(n);
+            for (int i = 0; i < n; ++i) {
+                if (i < layout.mK) {
+                    views[i] = DataRegion(file, g, layout.mK, i);
+                    targets[i] = const_cast<uint8_t*>(views[i].mData);
+                } else {
+                    targets[i] = sidecar.Data() + layout.OuterParityOffset(g, i - layout.mK);
+                    views[i] = {targets[i], kRegionBytes};
+                }
+                parities[i] = sidecar.Data() + layout.InnerParityOffset(g, i);
+            }
+            hamming::CodeWord< uint8_t, kRegionBytes > group;
+            std::vector<bool> changed;
+            if (!DecodeGroup(code, views, parities, report, group, changed)) {
+                report.mLostGroups++;
+                return;
+            }
+            // Записываются только измененные регионы (проверочные - после повторного кодирования группы).
+            for (int i = 0; i < n; ++i) {
+                if (!changed[i]) {
+                    continue;
+                }
+                const auto& region = group.at(i);
+                if (views[i].mData) {
+                    std::memcpy(targets[i], region.mSymbol.data(), views[i].mBytes);
+                }
+                ComputeInnerParity(code, {region.mSymbol.data(), kRegionBytes}, sidecar.Data() + layout.InnerParityOffset(g, i));
+                report.mRepairedRegions++;
+            }
+        });
+        std::cerr << "Corrected RS words: " << report.mCorrectedWords << ", erased regions: " << report.mErasedRegions
+                  << ", miscorrected regions: " << report.mMiscorrectedRegions
+                  << ", repaired regions: " << report.mRepairedRegions << ", lost groups: " << report.mLostGroups << '\n';
+        return report.mLostGroups == 0 ? 0 : 2;
+    }
+
+} // namespace parity
@@ -0,0 +1,199 @@
+/**
+ * Адаптивная политика глубины исправления ошибок внутренним кодом РС.
+ * По текущей статистике канала (доля искаженных слов, исходы коррекции и внешнего декодирования, EWMA)
+ * выбирается самый дешевый режим, при котором вероятности потери блока и ложного исправления
+ * не превышают заданных: на чистом канале искаженные слова просто стираются, на плохом - исправляются.
+ */
+
+#pragma once
+
+#include <cmath>     // std::pow, std::log1p, std::exp, std::lgamma
+#include <vector>    // std::vector
+#include <algorithm> // std::min, std::max
+#include "rsexh.hpp"
+
+namespace policy {
+
+    struct Config
+    {
+        double mAlpha = 0.02;               // Вес нового наблюдения в EWMA.
+        double mTargetLoss = 1.e-4;         // Допустимая вероятность потери блока.
+        double mTargetMiscorrection = 1.e-5; // Допустимая вероятность ложного исправления в блоке.
+        int mWarmup = 32;                   // Блоков до первого решения (до этого - Correct2).
+        int mHold = 64;                     // Блоков, которые более слабый режим должен оставаться лучшим до перехода.
+    };
+
+    /**
+     * Сглаженная статистика канала.
+     */
+    struct Stats
+    {
+        double mDirty = 0.;          // Доля слов РС с ненулевым синдромом.
+        double mFailed = 0.;         // Доля стертых слов РС.
+        double mBlockLoss = 0.;      // Доля потерянных блоков.
+        double mMiscorrections = 0.; // Обнаруженные ложные исправления на блок.
+        long long mBlocks = 0;
+    };
+
+    /**
+     * Прогноз модели для режима: вероятности потери блока и ложного исправления в блоке.
+     */
+    struct Forecast
+    {
+        double mLoss = 0.;
+        double mMiscorrection = 0.;
+    };
+
+    class AdaptivePolicy
+    {
+    public:
+        using Mode = rsexh::CorrectionMode;
+
+        /**
+         * @param n Количество слов РС в блоке (длина внешнего кода).
+         * @param distance Кодовое расстояние внешнего кода: гарантированно восстанавливается distance - 1 стираний.
+         */
+        AdaptivePolicy(int n, int distance, Config config = {})
+            : mN{n}, mDistance{distance}, mConfig{config}
+        {
+        }
+
+        /**
+         * Учесть результат декодирования блока.
+         * @param status Результаты коррекции слов РС (RsExh::mLastStatus).
+         * @param is_block_ok Блок декодирован.
+         * @param miscorrections Обнаруженные ложные исправления (RsExh::mLastMiscorrections).
+         */
+        void Observe(const std::vector<rsexh::InnerStatus>& status, bool is_block_ok, int miscorrections = 0)
+        {
+            int words = 0;
+            int dirty = 0;
+            int failed = 0;
+            for (const auto s : status) {
+                if (s == rsexh::InnerStatus::Skipped)
+                    continue;
+                words++;
+                dirty += s != rsexh::InnerStatus::Clean;
+                failed += s == rsexh::InnerStatus::Failed || s == rsexh::InnerStatus::Miscorrected;
+            }
+            const double alpha = mStats.mBlocks < mConfig.mWarmup ? 1. / (mStats.mBlocks + 1) : mConfig.mAlpha;
+            if (words > 0) {
+                mStats.mDirty += alpha * ((1. * dirty) / words - mStats.mDirty);
+                mStats.mFailed += alpha * ((1. * failed) / words - mStats.mFailed);
+            }
+            mStats.mBlockLoss += alpha * (!is_block_ok - mStats.mBlockLoss);
+            mStats.mMiscorrections += alpha * (miscorrections - mStats.mMiscorrections);
+            mStats.mBlocks++;
+            Decide();
+        }
+
+        Mode Current() const { return mMode; }
+
+        const Stats& GetStats() const { return mStats; }
+
+        /**
+         * Прогноз для режима по текущей оценке вероятности искажения символа РС.
+         * Слово искажено с вероятностью mDirty; отсюда вероятность ошибки символа и распределение
+         * кратности ошибок в слове. Ложное исправление - доля синдромов, попадающих в таблицы LUT.
+         */
+        Forecast Predict(Mode mode) const
+        {
+            constexpr int n = rsexh::RsExh::N;
+            constexpr double syndromes = 1 << (rsexh::RsExh::R * rsexh::RsExh::q);
+            constexpr double lut_1 = n * n;                               // Синдромы 1-ошибок.
+            constexpr double lut_2 = lut_1 + n * (n - 1) / 2. * n * n;    // И 2-ошибок.
+            const double eps = 1. - std::pow(1. - std::min(mStats.mDirty, 0.999999), 1. / n);
+            const double p0 = std::pow(1. - eps, n);
+            const double p1 = n * eps * std::pow(1. - eps, n - 1);
+            const double p2 = n * (n - 1) / 2. * eps * eps * std::pow(1. - eps, n - 2);
+            const double p3 = std::max(0., 1. - p0 - p1 - p2);
+            double erased = 0.;
+            double miscorrected = 0.;
+            switch (mode) {
+            case Mode::ErasureOnly:
+                erased = 1. - p0;
+                break;
+            case Mode::Correct1:
+                erased = p2 + p3;
+                miscorrected = (p2 + p3) * lut_1 / syndromes;
+                break;
+            case Mode::Correct2:
+                erased = p3;
+                miscorrected = p3 * lut_2 / syndromes;
+                break;
+            }
+            Forecast forecast;
+            forecast.mLoss = BinomialTail(mN, erased, mDistance);
+            forecast.mMiscorrection = std::min(1., mN * miscorrected);
+            if (mode == Mode::Correct2) {
+                // Наблюдаемые ложные исправления (если декодер их обнаруживает) учитываются для режима 2-ошибок.
+                forecast.mMiscorrection = std::max(forecast.mMiscorrection, mStats.mMiscorrections);
+            }
+            return forecast;
+        }
+
+    private:
+        /**
+         * P(X >= k), X ~ Bin(n, p); суммирование хвоста напрямую (без вычитания из единицы).
+         */
+        static double BinomialTail(int n, double p, int k)
+        {
+            if (p <= 0.)
+                return 0.;
+            if (p >= 1.)
+                return 1.;
+            double sum = 0.;
+            for (int i = k; i <= n; ++i) {
+                const double log_c = std::lgamma(n + 1.) - std::lgamma(i + 1.) - std::lgamma(n - i + 1.);
+                sum += std::exp(log_c + i * std::log(p) + (n - i) * std::log1p(-p));
+            }
+            return std::min(sum, 1.);
+        }
+
+        /**
+         * Выбрать самый дешевый режим, удовлетворяющий целям; если таких нет - с наименьшим взвешенным риском.
+         * Усиление режима - сразу, ослабление - после mHold блоков подряд с тем же выбором.
+         */
+        void Decide()
+        {
+            if (mStats.mBlocks < mConfig.mWarmup) {
+                return;
+            }
+            const Mode modes[] = {Mode::ErasureOnly, Mode::Correct1, Mode::Correct2};
+            const double weight = mConfig.mTargetLoss / mConfig.mTargetMiscorrection;
+            Mode best = Mode::Correct2;
+            double best_risk = -1.;
+            for (const auto mode : modes) {
+                const auto forecast = Predict(mode);
+                if (forecast.mLoss <= mConfig.mTargetLoss && forecast.mMiscorrection <= mConfig.mTargetMiscorrection) {
+                    best = mode;
+                    break;
+                }
+                const double risk = forecast.mLoss + weight * forecast.mMiscorrection;
+                if (best_risk < 0. || risk < best_risk) {
+                    best = mode;
+                    best_risk = risk;
+                }
+            }
+            if (best > mMode) {
+                mMode = best;
+                mPending = 0;
+            } else if (best < mMode) {
+                if (++mPending >= mConfig.mHold) {
+                    mMode = best;
+                    mPending = 0;
+                }
+            } else {
+                mPending = 0;
+            }
+        }
+
+        int mN;
+        int mDistance;
+        Config mConfig;
+        Stats mStats;
+        Mode mMode = Mode::Correct2;
+        int mPending = 0;
+    };
+
+} // namespace policy
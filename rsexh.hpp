@@ -1,12 +1,18 @@
 #pragma once
 
 #include <cmath> // std::pow
+#include <array> // std::array
+#include <cstdint> // uint32_t
 #include <string> // std::string
 #include <cassert> // assert
 #include <iostream> // std::cout
+#include <algorithm> // std::find
+#include <initializer_list> // std::initializer_list
+#include <memory> // std::shared_ptr
 #include "gf.hpp"
 #include "hamming.hpp"
 #include "utils.hpp" // power2
+#include "telemetry.hpp"
 
 namespace rsexh {
     template <typename T>
@@ -201,6 +207,30 @@ namespace rsexh {
         return result;
     }
 
+    /**
+     * Глубина исправления ошибок кодом РС (что не исправлено - стирается для внешнего кода).
+     */
+    enum class CorrectionMode {
+        ErasureOnly, // Только обнаружение: любое искаженное слово стирается.
+        Correct1,    // Исправление 1-ошибок.
+        Correct2     // Исправление 1- и 2-ошибок.
+    };
+
+    /**
+     * Результат коррекции кодового слова РС.
+     */
+    enum class InnerStatus
+    {
+        Clean,      // Синдром нулевой.
+        Corrected1, // Исправлена 1-ошибка.
+        Corrected2, // Исправлена 2-ошибка.
+        Failed,     // Ошибка обнаружена, но не исправлена.
+        Skipped,    // Слово не декодировалось (не потребовалось внешнему коду).
+        Corrected3, // Исправлена 3-ошибка: кандидат списочного декодирования, выбранный внешним кодом.
+        Recovered,  // Символ восстановлен внешним кодом при итеративном декодировании и сверен со словом РС.
+        Miscorrected // Исправление оказалось ложным (обнаружено внешним кодом), символ стерт.
+    };
+
     /**
      * Комбинация кода Рида-Соломона (РС) и расширенного кода Хэмминга, либо стороннего линейного блочного кода.
      * Код РС исправляет 1- и 2-х кратные ошибки по таблице LUT. В случае невозможности исправить - стирает 
@@ -208,12 +238,18 @@ namespace rsexh {
      * Чтобы не занимать много памяти, выбран короткий код РС.
      * Расширенный код Хэмминга работает в режиме восстановления стертых символов. Символом
      * для него является кодовый вектор кода РС.
+     * @tparam InnerR Количество проверочных символов кода РС.
+     * @tparam OuterR Количество проверочных символов внешнего кода.
      */
-    struct RsExh {
+    template <typename Code>
+    class DirectCorrector;
+
+    template <int InnerR = 5, int OuterR = 6>
+    struct RsExhT {
         static constexpr int p = 2;
         static constexpr int q = 4; // N = p^q - 1 - длина кода Рида-Соломона.
         static constexpr int N = utils::power<int>(p, q) - 1;
-        static constexpr int R = 5; // Количество проверочных символов кода Рида-Соломона.
+        static constexpr int R = InnerR; // Количество проверочных символов кода Рида-Соломона.
         static constexpr int K = N - R;
         // Кодовое расстояние.
         static constexpr int D = R + 1;
@@ -227,39 +263,47 @@ namespace rsexh {
         std::unordered_map< std::vector< int >, std::pair<int, int>, gf::KeyHasher2 > mLut_1_errors;
         // Таблица соответствия синдромов и им соответствующих двухкратных ошибок (2-ошибок).
         std::unordered_map< std::vector< int >, std::pair<int, std::pair<int, int>>, gf::KeyHasher2 > mLut_2_errors;
-        static constexpr int R2 = 6; // Количество проверочных символов расширенного кода Хэмминга.
-        static constexpr int M2 = K; // Количество внутренних символов расширенного кода Хэмминга.
+        static constexpr int R2 = OuterR; // Количество проверочных символов внешнего кода.
+        static constexpr int M2 = K; // Количество внутренних символов внешнего кода.
+        // Внешний код: по умолчанию расширенный код Хэмминга, либо код с заданной проверочной матрицей.
         hamming::HammingExtended< int, R2, M2 > mHammingCode;
+        // Быстрая табличная арифметика поля GF(p^q) в векторной форме.
+        gf::FastGF2< q > mFast{ mLut };
+        // Таблица систематического кодирования: вклад значения информационного символа на позиции j
+        // в проверочные символы (векторная форма, по q бит на символ).
+        static_assert(R * q <= 32, "Packed parity must fit in uint32_t");
+        std::array< std::array< uint32_t, N + 1 >, K > mSysParity{};
 
-        // static constexpr int R2 = 11; // Количество проверочных символов внешнего кода.
-        // static constexpr int M2 = K; // Количество внутренних символов внешнего кода.
-        // hamming::HammingExtended< int, R2, M2 > mHammingCode{
-        //     Matrix<int>{ // Код Голея, циклический. Кодовое расстояние - 7.
-        //         {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1}, 
-        //         {0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0}, 
-        //         {0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0}, 
-        //         {0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0}, 
-        //         {0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0}, 
-        //         {0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}, 
-        //         {0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0}, 
-        //         {0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, 
-        //         {0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0}, 
-        //         {0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 
-        //         {1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
-        //     }, 7
-        // };
+        /**
+         * Конструктор с внешним кодом по умолчанию (расширенный код Хэмминга).
+         */
+        RsExhT()
+        {
+            Init();
+        }
 
         /**
-         * Конструктор. Заполняется таблица для исправления однократных ошибок.
+         * Конструктор со сторонним внешним кодом, например кодом Голея (R2 = 11).
+         * @param outer_parity Проверочная матрица внешнего кода, R2 строк.
+         * @param outer_distance Кодовое расстояние внешнего кода.
          */
-        RsExh()
+        RsExhT(const Matrix<int>& outer_parity, int outer_distance)
+            : mHammingCode{outer_parity, outer_distance}
+        {
+            Init();
+        }
+
+        /**
+         * Заполняются таблицы для исправления 1- и 2-ошибок и систематического кодирования.
+         */
+        void Init()
         {
             assert(mIsGood);
             if (!mIsGood) {
-                std::cout << "Polynomial is not good for RS code!\n";
+                std::cerr << "Polynomial is not good for RS code!\n";
                 return;
             }
-            std::cout << "Polynomial is good\n";
+            std::cerr << "Polynomial is good\n";
             mLut_1_errors.clear();
             mLut_2_errors.clear();
             const int N = std::pow( p, q ) - 1;
@@ -315,6 +359,711 @@ namespace rsexh {
                     }
                 }
             }
+            FillSystematicTables();
+        }
+
+        /**
+         * Заполнить таблицу систематического кодирования. Информационные символы занимают позиции 0..K-1,
+         * проверочные - позиции K..N-1; проверочная матрица та же, что и у несистематического кода,
+         * поэтому исправление ошибок по LUT работает без изменений.
+         */
+        void FillSystematicTables()
+        {
+            // Столбцы H на проверочных позициях: A[i][t] = alpha^((K + t) * (i + 1)). Обращение методом Гаусса-Жордана.
+            std::array< std::array< int, 2 * R >, R > a{};
+            for (int i = 0; i < R; ++i) {
+                for (int t = 0; t < R; ++t) {
+                    a[i][t] = mFast.Exp(((K + t) * (i + 1)) % N);
+                }
+                a[i][R + i] = 1;
+            }
+            for (int col = 0; col < R; ++col) {
+                int pivot = col;
+                while (a[pivot][col] == 0) {
+                    pivot++;
+                }
+                std::swap(a[col], a[pivot]);
+                const int inv = mFast.Inv(a[col][col]);
+                for (auto& el : a[col]) {
+                    el = mFast.Mult(el, inv);
+                }
+                for (int i = 0; i < R; ++i) {
+                    if (i == col || a[i][col] == 0)
+                        continue;
+                    const int factor = a[i][col];
+                    for (int k = 0; k < 2 * R; ++k) {
+                        a[i][k] ^= mFast.Mult(factor, a[col][k]);
+                    }
+                }
+            }
+            for (int j = 0; j < K; ++j) {
+                for (int x = 1; x <= N; ++x) {
+                    // Синдром, создаваемый символом x на позиции j; проверочные символы должны его погасить.
+                    std::array< int, R > c{};
+                    for (int i = 0; i < R; ++i) {
+                        c[i] = mFast.Mult(mFast.FromValue(x), mFast.Exp((j * (i + 1)) % N));
+                    }
+                    uint32_t packed = 0;
+                    for (int t = 0; t < R; ++t) {
+                        int parity = 0;
+                        for (int i = 0; i < R; ++i) {
+                            parity ^= mFast.Mult(a[t][R + i], c[i]);
+                        }
+                        packed |= uint32_t(parity) << (q * t);
+                    }
+                    mSysParity[j][x] = packed;
+                }
+            }
+        }
+
+        /**
+         * Систематическое кодирование кодом РС по таблице: K информационных символов -> R проверочных.
+         * Символы в том же представлении, что и в кодовых словах ("индекс + 1").
+         */
+        void EncodeSystematic(const int* data, int* parity) const
+        {
+            uint32_t packed = 0;
+            for (int j = 0; j < K; ++j) {
+                packed ^= mSysParity[j][data[j]];
+            }
+            for (int t = 0; t < R; ++t) {
+                parity[t] = mFast.ToValue((packed >> (q * t)) & N);
+            }
+        }
+
+        /**
+         * Включить/выключить табличный режим слов РС: систематическое кодирование таблицей mSysParity
+         * и исправление прямой индексацией (DirectCorrector) вместо несистематического кодирования и LUT
+         * со сдвигами синдрома - без выделений памяти. Кодовые слова у режимов разные, поэтому кодер и
+         * декодер должны работать в одном режиме. Таблица поправок (2 МиБ при R = 5) разделяется копиями кода.
+         */
+        void SwitchToDirect(bool is_direct)
+        {
+            mDirect = is_direct ? std::make_shared<const DirectCorrector<RsExhT>>(*this) : nullptr;
+        }
+
+        bool IsDirect() const { return mDirect != nullptr; }
+
+        /**
+         * Исправить ошибки в кодовом слове РС по таблицам LUT: сначала 1-ошибки, затем 2-ошибки.
+         * Телеметрию не пишет: исходы считаются при декодировании блоков (DecodeSymbol).
+         * @param mode Глубина исправления; в режиме ErasureOnly любое искаженное слово - неисправимое.
+         * @param shifts Если задан - число итераций цикла сдвигов синдрома.
+         */
+        InnerStatus Correct(std::vector<int>& v, CorrectionMode mode = CorrectionMode::Correct2, int* shifts = nullptr) const
+        {
+            if (shifts)
+                *shifts = 0;
+            auto c = CalculateSyndrome(v, R, mGf);
+            bool is_ok = true;
+            for (const auto& el_c: c) {
+                is_ok &= el_c == 0;
+            }
+            if (is_ok) {
+                return InnerStatus::Clean;
+            }
+            if (mode == CorrectionMode::ErasureOnly) {
+                return InnerStatus::Failed;
+            }
+            if (auto it = mLut_1_errors.find(c); it != mLut_1_errors.end()) {
+                const auto [pos, corrector_idx] = it->second;
+                const int channel_value = v.at(pos);
+                v[pos] = mGf.Sub(channel_value - 1, corrector_idx) + 1; // idx = value - 1 => value = idx + 1.
+                return InnerStatus::Corrected1;
+            }
+            if (mode == CorrectionMode::Correct1) {
+                return InnerStatus::Failed;
+            }
+            for (int k = 0; k < N - 1; k++) {
+                if (auto it = mLut_2_errors.find(c); it != mLut_2_errors.end()) {
+                    if (shifts)
+                        *shifts = k + 1;
+                    const auto [pos_2nd, corrector_indices] = it->second;
+                    const int idx_1 = k;
+                    const int idx_2 = pos_2nd + k;
+                    if (idx_2 >= N) { // Такая 2-ошибка нашлась бы на меньшем сдвиге: ошибка неисправима.
+                        return InnerStatus::Failed;
+                    }
+                    const auto [corrector_idx_1, corrector_idx_2] = corrector_indices;
+                    v[idx_1] = mGf.Sub(v.at(idx_1) - 1, corrector_idx_1) + 1;
+                    v[idx_2] = mGf.Sub(v.at(idx_2) - 1, corrector_idx_2) + 1;
+                    return InnerStatus::Corrected2;
+                }
+                ShiftLeftSyndrome<p, q>(c); // Сдвиг - имеется ввиду сдвиг соответствующего вектора ошибки.
+            }
+            if (shifts)
+                *shifts = N - 1;
+            return InnerStatus::Failed;
+        }
+
+        /**
+         * Исправить и декодировать кодовое слово РС в символ внешнего кода.
+         * Неисправимое слово дает стертый символ.
+         * @param is_counted Записать исход в телеметрию; false - пробное декодирование (ListDecode).
+         */
+        InnerStatus DecodeSymbol(std::vector<int>& v, hamming::CodeElement<int, M2>& symbol,
+                                 CorrectionMode mode = CorrectionMode::Correct2, bool is_counted = true) const
+        {
+            int shifts = 0;
+            const auto status = mDirect ? mDirect->Correct(v, mode) : Correct(v, mode, &shifts);
+            if (is_counted)
+                RecordInner(status, shifts);
+            if (status == InnerStatus::Failed) {
+                symbol.mStatus = hamming::SymbolStatus::Erased;
+                symbol.mSymbol.fill(-1);
+                return status;
+            }
+            if (mDirect) { // Систематический код: информационные символы - первые K символов слова.
+                std::copy(v.begin(), v.begin() + M2, symbol.mSymbol.begin());
+            } else {
+                const auto a_dec = Decode(v, R, mGf);
+                for (int j = 0; j < M2; ++j) {
+                    symbol.mSymbol[j] = a_dec.at(j);
+                }
+            }
+            symbol.mStatus = hamming::SymbolStatus::Normal;
+            return status;
+        }
+
+        /**
+         * Телеметрия внутреннего декодирования слова: исход и итерации сдвигов синдрома.
+         */
+        void RecordInner([[maybe_unused]] InnerStatus status, [[maybe_unused]] int shifts) const
+        {
+            RSEXH_COUNT(InnerWords, 1);
+            RSEXH_COUNT(ShiftIterations, shifts);
+            switch (status) {
+            case InnerStatus::Clean:
+                RSEXH_COUNT(InnerClean, 1);
+                break;
+            case InnerStatus::Corrected1:
+                RSEXH_COUNT(InnerCorrected1, 1);
+                break;
+            case InnerStatus::Corrected2:
+                RSEXH_COUNT(InnerCorrected2, 1);
+                break;
+            default:
+                RSEXH_COUNT(InnerFailed, 1);
+                break;
+            }
+        }
+
+        /**
+         * Закодировать блок: внешним кодом, затем каждый символ внешнего кода - кодом РС.
+         * @param a Информационные символы внешнего кода, всего K символов.
+         * @param v Кодовые слова РС, всего N слов внешнего кода.
+         */
+        void EncodeBlock(const hamming::CodeWord<int, M2>& a, Matrix<int>& v)
+        {
+            const auto s_h = mHammingCode.Encode(a);
+            v.resize(s_h.size());
+            for (std::size_t i = 0; i < s_h.size(); ++i) {
+                v[i].resize(N);
+                EncodeWord(s_h[i], v[i]);
+            }
+        }
+
+        /**
+         * Закодировать символ внешнего кода в слово РС (N символов) в текущем режиме (см. SwitchToDirect).
+         */
+        void EncodeWord(const hamming::CodeElement<int, M2>& symbol, std::vector<int>& word) const
+        {
+            if (mDirect) {
+                std::copy(symbol.mSymbol.begin(), symbol.mSymbol.end(), word.begin());
+                EncodeSystematic(word.data(), word.data() + K);
+                return;
+            }
+            word = Encode(std::vector<int>(symbol.mSymbol.begin(), symbol.mSymbol.end()), mGf);
+        }
+
+        /**
+         * Декодировать блок: коррекция ошибок кодом РС, затем восстановление стертых символов внешним кодом.
+         * В ленивом режиме сначала декодируются только K слов РС с информационными символами внешнего кода;
+         * проверочные слова декодируются, лишь если какой-то информационный символ стерт.
+         * Успех означает, что все стертые символы восстановлены (mHammingCode.mIsSolved после вызова тоже true).
+         * @param v Принятые кодовые слова РС (исправляются на месте). Пустое слово считается стертым.
+         * @param a Декодированные информационные символы внешнего кода.
+         * @param erased Количество стертых символов внешнего кода.
+         * @param lazy Ленивый режим.
+         */
+        bool DecodeBlock(Matrix<int>& v, hamming::CodeWord<int, M2>& a, int& erased, bool lazy = true)
+        {
+            RSEXH_TIME(DecodeLatency);
+            a.resize(v.size());
+            mLastStatus.assign(v.size(), InnerStatus::Skipped);
+            auto decode_word = [this, &v, &a](int i) {
+                if (v[i].size() != N) { // Слово не принято (потеряно): символ стерт.
+                    a[i].mStatus = hamming::SymbolStatus::Erased;
+                    a[i].mSymbol.fill(-1);
+                    mLastStatus[i] = InnerStatus::Failed;
+                    return;
+                }
+                mLastStatus[i] = DecodeSymbol(v[i], a[i], mMode);
+            };
+            if (lazy) {
+                const auto& info = mHammingCode.InformationPositions();
+                bool has_erasure = false;
+                for (const auto i : info) {
+                    decode_word(i);
+                    has_erasure |= a[i].mStatus == hamming::SymbolStatus::Erased;
+                }
+                if (!has_erasure) {
+                    hamming::CodeWord<int, M2> result(info.size());
+                    for (std::size_t k = 0; k < info.size(); ++k)
+                        result[k] = a[info[k]];
+                    a = std::move(result);
+                    erased = 0;
+                    mHammingCode.mIsSolved = true; // Внешний декодер не вызывался: состояние прошлого блока.
+                    RecordOuter(true, erased);
+                    return true;
+                }
+            }
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                if (mLastStatus[i] == InnerStatus::Skipped)
+                    decode_word(i);
+            }
+            const bool is_ok = mHammingCode.Decode(a, erased) && mHammingCode.mIsSolved;
+            RecordOuter(is_ok, erased);
+            return is_ok;
+        }
+
+        /**
+         * Телеметрия внешнего декодирования блока: стирания и отказ (в том числе вырожденная подматрица).
+         * @param is_solved Итог декодирования блока, который возвращает вызывающий (не mIsSolved: внешний
+         * декодер мог не вызываться).
+         */
+        void RecordOuter([[maybe_unused]] bool is_solved, [[maybe_unused]] int erased) const
+        {
+            RSEXH_COUNT(OuterBlocks, 1);
+            RSEXH_COUNT(OuterErasures, erased);
+            RSEXH_RECORD(OuterErasures, erased);
+            if (!is_solved)
+                RSEXH_COUNT(OuterFailures, 1);
+        }
+
+        /**
+         * Частичное декодирование блока: восстановить только информационные символы внешнего кода с номерами wanted.
+         * Декодируются лишь те слова РС, которые нужны для этого (см. HammingExtended::DecodeSelected).
+         * @return Количество декодированных слов РС или -1, если восстановить не удалось.
+         */
+        int DecodeSelected(Matrix<int>& v, const std::vector<int>& wanted, hamming::CodeWord<int, M2>& a)
+        {
+            mLastStatus.assign(v.size(), InnerStatus::Skipped);
+            hamming::CodeElement<int, M2> symbol;
+            return mHammingCode.DecodeSelected(wanted, [this, &v, &symbol](int i) {
+                if (v[i].size() != N) {
+                    symbol.mStatus = hamming::SymbolStatus::Erased;
+                    symbol.mSymbol.fill(-1);
+                    mLastStatus[i] = InnerStatus::Failed;
+                } else {
+                    mLastStatus[i] = DecodeSymbol(v[i], symbol, mMode);
+                }
+                return symbol;
+            }, a);
+        }
+
+        /**
+         * Списочное декодирование слова РС: все информационные векторы кодовых слов на расстоянии 3 от v.
+         * Перебираются предполагаемая стертая позиция и ее значение, остальное исправляет 2-ошибочный декодер.
+         */
+        std::vector<hamming::CodeElement<int, M2>> ListDecode(const std::vector<int>& v) const
+        {
+            std::vector<hamming::CodeElement<int, M2>> candidates;
+            std::vector<int> trial;
+            hamming::CodeElement<int, M2> symbol;
+            for (int pos = 0; pos < N; ++pos) {
+                for (int value = 0; value <= N; ++value) {
+                    if (value == v[pos])
+                        continue;
+                    trial = v;
+                    trial[pos] = value;
+                    if (DecodeSymbol(trial, symbol, CorrectionMode::Correct2, false) == InnerStatus::Failed)
+                        continue;
+                    if (std::find(candidates.begin(), candidates.end(), symbol) == candidates.end())
+                        candidates.push_back(symbol);
+                }
+            }
+            return candidates;
+        }
+
+        /**
+         * Итеративное декодирование блока (внутренний и внешний коды обмениваются информацией).
+         * Решение внешнего кода проверяется: принятые символы ему не противоречат, а восстановленные символы
+         * близки к принятым словам РС (IsNear), поэтому не считаются угаданными. Если однократное
+         * декодирование не дало проверенного решения, то до iterations раз:
+         * - противоречащие решению символы стираются, и их словам больше не доверяем;
+         * - стертые слова декодируются списочно (3-ошибки), и каждый кандидат пробуется внешним кодом:
+         *   принимается первое проверенное решение;
+         * - иначе единственные кандидаты принимаются предварительно, и итерация повторяется.
+         * Угаданных символов (кандидатов списков) вместе с восстановленными без принятого слова (сверить
+         * не с чем) не больше D - 1: тогда ошибка среди угаданных символов не может остаться незамеченной.
+         * Если решения нет, восстанавливаются результат и состояние (mIsSolved, mLastStatus)
+         * однократного декодирования, и возвращается false.
+         * @param iterations Бюджет итераций.
+         */
+        bool DecodeBlockIterative(Matrix<int>& v, hamming::CodeWord<int, M2>& a, int& erased, int iterations = 4)
+        {
+            RSEXH_TIME(DecodeLatency);
+            const auto received = v;
+            const int n = v.size();
+            hamming::CodeWord<int, M2> symbols;
+            DecodeWords(v, symbols);
+            // Внешнее декодирование и проверка решения (conflicts - противоречащие ему принятые символы,
+            // unchecked - восстановленные символы без принятого слова РС).
+            std::vector<int> conflicts;
+            int unchecked = 0;
+            auto try_outer = [&](hamming::CodeWord<int, M2>& result, int& result_erased) {
+                result = symbols;
+                conflicts.clear();
+                unchecked = 0;
+                if (!mHammingCode.Decode(result, result_erased) || !mHammingCode.mIsSolved)
+                    return false;
+                const auto encoded = mHammingCode.Encode(result);
+                for (int i = 0; i < n; ++i) {
+                    if (symbols[i].mStatus == hamming::SymbolStatus::Normal && !(symbols[i] == encoded[i]))
+                        conflicts.push_back(i);
+                }
+                return IsNear(received, symbols, encoded, unchecked) && conflicts.empty();
+            };
+            auto guessed = [this] {
+                return std::count(mLastStatus.begin(), mLastStatus.end(), InnerStatus::Corrected3);
+            };
+            hamming::CodeWord<int, M2> result;
+            int result_erased;
+            auto accept = [&] {
+                for (int i = 0; i < n; ++i) {
+                    if (symbols[i].mStatus == hamming::SymbolStatus::Erased && received[i].size() == N)
+                        mLastStatus[i] = InnerStatus::Recovered;
+                }
+                a = std::move(result);
+                erased = result_erased;
+                RecordOuter(true, erased);
+                return true;
+            };
+            if (try_outer(result, result_erased))
+                return accept();
+            a = result;
+            erased = result_erased;
+            const bool is_solved_one_shot = mHammingCode.mIsSolved;
+            const auto status_one_shot = mLastStatus;
+            std::vector<std::vector<hamming::CodeElement<int, M2>>> candidates(n);
+            std::vector<bool> is_listed(n, false);
+            for (int it = 0; it < iterations; ++it) {
+                bool progress = !conflicts.empty();
+                // Противоречащие внешнему коду символы стираются.
+                for (const int i : conflicts) {
+                    symbols[i].mStatus = hamming::SymbolStatus::Erased;
+                    symbols[i].mSymbol.fill(-1);
+                    mLastStatus[i] = InnerStatus::Failed;
+                    is_listed[i] = true; // Кандидатам этого слова больше не доверяем.
+                    candidates[i].clear();
+                }
+                // Списочное декодирование стертых слов и проба каждого кандидата внешним кодом.
+                for (int i = 0; i < n; ++i) {
+                    if (symbols[i].mStatus != hamming::SymbolStatus::Erased || received[i].size() != N)
+                        continue;
+                    if (!is_listed[i]) {
+                        is_listed[i] = true;
+                        candidates[i] = ListDecode(received[i]);
+                    }
+                    mLastStatus[i] = InnerStatus::Corrected3;
+                    for (const auto& candidate : candidates[i]) {
+                        symbols[i] = candidate;
+                        if (try_outer(result, result_erased) && guessed() + unchecked <= mHammingCode.D - 1)
+                            return accept();
+                    }
+                    symbols[i].mStatus = hamming::SymbolStatus::Erased;
+                    symbols[i].mSymbol.fill(-1);
+                    mLastStatus[i] = InnerStatus::Failed;
+                }
+                // Единственные кандидаты принимаются предварительно: неверные дадут противоречия.
+                for (int i = 0; i < n; ++i) {
+                    if (symbols[i].mStatus != hamming::SymbolStatus::Erased || candidates[i].size() != 1)
+                        continue;
+                    symbols[i] = candidates[i].front();
+                    mLastStatus[i] = InnerStatus::Corrected3;
+                    candidates[i].clear();
+                    progress = true;
+                }
+                if (!progress) {
+                    break;
+                }
+                if (try_outer(result, result_erased) && guessed() + unchecked <= mHammingCode.D - 1)
+                    return accept();
+            }
+            mHammingCode.mIsSolved = is_solved_one_shot;
+            mLastStatus = status_one_shot;
+            RecordOuter(false, erased);
+            return false;
         }
+
+        /**
+         * Количество позиций, в которых принятое слово РС отличается от кодового слова символа symbol.
+         */
+        int Distance(const std::vector<int>& received, const hamming::CodeElement<int, M2>& symbol) const
+        {
+            std::vector<int> word(N);
+            EncodeWord(symbol, word);
+            int distance = 0;
+            for (int j = 0; j < N; ++j)
+                distance += word[j] != received[j];
+            return distance;
+        }
+
+        /**
+         * Сверка восстановленных внешним кодом символов (стертых в symbols) с принятыми словами РС received:
+         * кодовое слово восстановленного символа отличается от принятого не более чем в N / 2 позициях
+         * (случайное кодовое слово РС (15, 10) так близко с вероятностью около 1e-6).
+         * @param encoded Кодовое слово внешнего кода с восстановленными символами.
+         * @param unchecked Количество восстановленных символов без принятого слова (сверить не с чем).
+         */
+        bool IsNear(const Matrix<int>& received, const hamming::CodeWord<int, M2>& symbols,
+                    const hamming::CodeWord<int, M2>& encoded, int& unchecked) const
+        {
+            unchecked = 0;
+            for (std::size_t i = 0; i < symbols.size(); ++i) {
+                if (symbols[i].mStatus == hamming::SymbolStatus::Normal)
+                    continue;
+                if (received[i].size() != N) {
+                    unchecked++;
+                } else if (Distance(received[i], encoded[i]) > N / 2) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Декодирование блока с обнаружением ложных исправлений кода РС.
+         * После восстановления стертых символов проверяется синдром внешнего кода (стертые символы
+         * заменены восстановленными). Если он ненулевой, то ложно исправленные символы ищутся пробным
+         * стиранием: сначала по одному, затем парами среди исправленных слов, в пределах оставшейся избыточности.
+         * Принимается только единственное согласованное решение; иначе блок считается необнаружимо
+         * восстановимым: возвращается false и выставляется mLastInconsistent.
+         * Если стираний больше D - 2, запаса проверок нет, и ложное исправление не дает противоречия, но
+         * искажает восстановленные символы: они сверяются с принятыми словами РС (IsNear), и далекий
+         * от принятого слова восстановленный символ делает блок несогласованным.
+         */
+        bool DecodeBlockVerified(Matrix<int>& v, hamming::CodeWord<int, M2>& a, int& erased)
+        {
+            RSEXH_TIME(DecodeLatency);
+            hamming::CodeWord<int, M2> symbols;
+            DecodeWords(v, symbols);
+            mLastMiscorrections = 0;
+            mLastInconsistent = false;
+            a = symbols;
+            if (!mHammingCode.Decode(a, erased) || !mHammingCode.mIsSolved) {
+                RecordOuter(false, erased);
+                return false;
+            }
+            const int n = symbols.size();
+            if (IsConsistent(symbols, a)) {
+                bool is_checked = true;
+                if (erased > mHammingCode.D - 2) {
+                    int unchecked;
+                    is_checked = IsNear(v, symbols, mHammingCode.Encode(a), unchecked);
+                    mHammingCode.mIsSolved = is_checked;
+                }
+                mLastInconsistent = !is_checked;
+                RecordOuter(is_checked, erased);
+                return is_checked;
+            }
+            std::vector<int> suspects;
+            std::vector<int> corrected;
+            for (int i = 0; i < n; ++i) {
+                if (symbols[i].mStatus != hamming::SymbolStatus::Normal)
+                    continue;
+                suspects.push_back(i);
+                if (mLastStatus[i] == InnerStatus::Corrected1 || mLastStatus[i] == InnerStatus::Corrected2)
+                    corrected.push_back(i);
+            }
+            // Пробное стирание набора символов; true - решение согласовано.
+            hamming::CodeWord<int, M2> trial;
+            hamming::CodeWord<int, M2> result;
+            int result_erased;
+            auto try_erase = [&](std::initializer_list<int> ids) {
+                trial = symbols;
+                for (const int i : ids) {
+                    trial[i].mStatus = hamming::SymbolStatus::Erased;
+                    trial[i].mSymbol.fill(-1);
+                }
+                result = trial;
+                return mHammingCode.Decode(result, result_erased) && mHammingCode.mIsSolved && IsConsistent(trial, result);
+            };
+            const int budget = mHammingCode.D - 2 - erased; // Стираний еще можно добавить, сохранив обнаружение.
+            std::vector<std::vector<int>> found;
+            hamming::CodeWord<int, M2> found_result;
+            int found_erased = 0;
+            auto accept = [&](std::vector<int> ids) {
+                found.push_back(std::move(ids));
+                found_result = result;
+                found_erased = result_erased;
+            };
+            if (budget >= 1) {
+                for (const int i : suspects) {
+                    if (try_erase({i}))
+                        accept({i});
+                }
+            }
+            if (found.empty() && budget >= 2) {
+                for (std::size_t x = 0; x < corrected.size(); ++x) {
+                    for (std::size_t y = x + 1; y < corrected.size(); ++y) {
+                        if (try_erase({corrected[x], corrected[y]}))
+                            accept({corrected[x], corrected[y]});
+                    }
+                }
+            }
+            if (found.size() != 1) {
+                mLastInconsistent = true;
+                RecordOuter(false, erased);
+                return false;
+            }
+            for (const int i : found.front())
+                mLastStatus[i] = InnerStatus::Miscorrected;
+            mLastMiscorrections = found.front().size();
+            a = std::move(found_result);
+            erased = found_erased;
+            RSEXH_COUNT(OuterMiscorrections, mLastMiscorrections);
+            RecordOuter(true, erased);
+            return true;
+        }
+
+        /**
+         * Согласованность решения внешнего кода info (K символов) с принятыми символами symbols:
+         * синдром вектора, в котором стертые символы заменены восстановленными, нулевой.
+         */
+        bool IsConsistent(const hamming::CodeWord<int, M2>& symbols, const hamming::CodeWord<int, M2>& info)
+        {
+            auto filled = mHammingCode.Encode(info);
+            for (std::size_t i = 0; i < symbols.size(); ++i) {
+                if (symbols[i].mStatus == hamming::SymbolStatus::Normal)
+                    filled[i] = symbols[i];
+            }
+            for (const auto& el : mHammingCode.CalcSyndrome(filled)) {
+                for (const auto x : el.mSymbol) {
+                    if (x != 0)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Декодировать все слова РС блока в символы внешнего кода (без внешнего декодирования).
+         */
+        void DecodeWords(Matrix<int>& v, hamming::CodeWord<int, M2>& symbols)
+        {
+            const int n = v.size();
+            symbols.resize(n);
+            mLastStatus.assign(n, InnerStatus::Skipped);
+            for (int i = 0; i < n; ++i) {
+                if (v[i].size() != N) {
+                    symbols[i].mStatus = hamming::SymbolStatus::Erased;
+                    symbols[i].mSymbol.fill(-1);
+                    mLastStatus[i] = InnerStatus::Failed;
+                    continue;
+                }
+                mLastStatus[i] = DecodeSymbol(v[i], symbols[i], mMode);
+            }
+        }
+
+        // Глубина исправления ошибок при декодировании блоков.
+        CorrectionMode mMode = CorrectionMode::Correct2;
+
+        // Количество обнаруженных и стертых ложных исправлений в последнем блоке (DecodeBlockVerified).
+        int mLastMiscorrections = 0;
+        // Последний блок несогласован, и ложные исправления локализовать не удалось.
+        bool mLastInconsistent = false;
+
+        // Результаты коррекции слов РС последнего декодированного блока.
+        std::vector<InnerStatus> mLastStatus;
+
+        // Исправление прямой индексацией в табличном режиме (SwitchToDirect); пусто - LUT.
+        std::shared_ptr<const DirectCorrector<RsExhT>> mDirect;
+    };
+
+    /**
+     * Код по умолчанию: РС (15, 10) и расширенный код Хэмминга (32, 26).
+     */
+    using RsExh = RsExhT<>;
+
+    /**
+     * Исправление 1- и 2-ошибок кода РС прямой индексацией: упакованный синдром (по q бит на компоненту)
+     * считается таблицами столбцов H быстрой арифметики GF и сразу является индексом в таблице поправок
+     * на все p^(q R) синдромов (2 байта на синдром: 2 МиБ при R = 5, 32 МиБ при R = 6).
+     * Без хеш-таблиц, сдвигов синдрома и выделений памяти; результат совпадает с RsExhT::Correct().
+     */
+    template <typename Code>
+    class DirectCorrector
+    {
+    public:
+        static constexpr int N = Code::N;
+        static constexpr int R = Code::R;
+        static constexpr int q = Code::q;
+
+        explicit DirectCorrector(const Code& code) : mFast{code.mFast}, mTable(std::size_t(1) << (q * R), kNone)
+        {
+            for (int j = 0; j < N; ++j) {
+                for (int x = 1; x <= N; ++x) {
+                    mColumns[j][x] = 0;
+                    for (int i = 0; i < R; ++i)
+                        mColumns[j][x] |= uint32_t(mFast.Mult(mFast.FromValue(x), mFast.Exp((j * (i + 1)) % N))) << (q * i);
+                }
+            }
+            // Поправка: позиции и значения ошибок по q бит; позиция N - ошибки нет.
+            for (int i = 0; i < N; ++i) {
+                for (int x = 1; x <= N; ++x) {
+                    mTable[mColumns[i][x]] = Pack(i, x, N, 0);
+                    for (int k = i + 1; k < N; ++k) {
+                        for (int y = 1; y <= N; ++y)
+                            mTable[mColumns[i][x] ^ mColumns[k][y]] = Pack(i, x, k, y);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Упакованный синдром слова (символы в представлении "индекс + 1").
+         */
+        uint32_t Syndrome(const std::vector<int>& v) const
+        {
+            uint32_t syndrome = 0;
+            for (int j = 0; j < N; ++j)
+                syndrome ^= mColumns[j][v[j]];
+            return syndrome;
+        }
+
+        InnerStatus Correct(std::vector<int>& v, CorrectionMode mode = CorrectionMode::Correct2) const
+        {
+            const uint32_t syndrome = Syndrome(v);
+            if (syndrome == 0)
+                return InnerStatus::Clean;
+            const uint16_t fix = mTable[syndrome];
+            const int weight = fix == kNone ? 3 : (((fix >> (2 * q)) & N) == N ? 1 : 2);
+            if (weight > int(mode))
+                return InnerStatus::Failed;
+            Apply(v, fix & N, (fix >> q) & N);
+            if (weight == 1)
+                return InnerStatus::Corrected1;
+            Apply(v, (fix >> (2 * q)) & N, (fix >> (3 * q)) & N);
+            return InnerStatus::Corrected2;
+        }
+
+    private:
+        static constexpr uint16_t kNone = 0xFFFF;
+
+        static uint16_t Pack(int pos1, int value1, int pos2, int value2)
+        {
+            return uint16_t(pos1 | (value1 << q) | (pos2 << (2 * q)) | (value2 << (3 * q)));
+        }
+
+        void Apply(std::vector<int>& v, int pos, int value) const
+        {
+            v[pos] = mFast.ToValue(mFast.FromValue(v[pos]) ^ mFast.FromValue(value));
+        }
+
+        gf::FastGF2< q > mFast;
+        std::array< std::array< uint32_t, N + 1 >, N > mColumns{};
+        std::vector< uint16_t > mTable;
     };
 }
@@ -0,0 +1,423 @@
+/**
+ * Многопоточная оценка BER каскадного кода методом Монте-Карло.
+ * Случайные числа каждого блока берутся из собственного потока счетного генератора (ключ - зерно
+ * и номер блока), поэтому результат при заданном зерне не зависит ни от числа потоков,
+ * ни от порядка, в котором потоки разобрали блоки. Счетчики ошибок складываются атомарно, без блокировок.
+ */
+
+#pragma once
+
+#include <cassert>   // assert
+#include <cstdint>   // uint64_t
+#include <cmath>     // std::log, std::log1p, std::lgamma, std::exp, std::sqrt
+#include <atomic>    // std::atomic
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+#include <algorithm> // std::min, std::max, std::find
+#include <bit>       // std::popcount
+#include "rsexh.hpp"
+#include "channel.hpp"
+
+namespace sim {
+
+    using channel::CounterRng;
+
+    struct Config
+    {
+        double mBer = 0.01;          // Вероятность ошибки бита в двоичном симметричном канале (если модель не задана).
+        long long mFirstBlock = 0;   // Номер первого блока (для продолжения серии тем же зерном).
+        long long mBlocks = 10000;   // Количество блоков.
+        uint64_t mSeed = 1;
+        int mThreads = 0;            // 0 - по числу аппаратных потоков.
+        int mChunk = 256;            // Блоков, забираемых потоком за раз.
+    };
+
+    struct Result
+    {
+        long long mBlocks = 0;
+        long long mBits = 0;         // Переданных информационных бит.
+        long long mBitErrors = 0;    // Ошибочных информационных бит (стертый символ - половина бит).
+        long long mBlockErrors = 0;  // Блоков с ошибкой или стиранием.
+
+        double Ber() const { return mBits > 0 ? (1. * mBitErrors) / mBits : 0.; }
+    };
+
+    /**
+     * Один блок: источник, кодирование, канал channel(v), декодирование, подсчет ошибок.
+     * Все случайные числа - из rng, так что результат определяется только зерном и номером блока.
+     * @return Количество ошибочных информационных бит блока.
+     */
+    template <typename Code, typename Channel>
+    inline long long SimulateBlock(Code& code, CounterRng& rng, Channel&& channel, Result& counts)
+    {
+        constexpr int M2 = Code::M2;
+        const int K = code.mHammingCode.K;
+        hamming::CodeWord<int, M2> a(K);
+        uint64_t bits = 0;
+        int left = 0;
+        for (auto& el : a) {
+            el.mStatus = hamming::SymbolStatus::Normal;
+            for (auto& symbol : el.mSymbol) {
+                if (left == 0) {
+                    bits = rng.Next();
+                    left = 16;
+                }
+                symbol = bits & 15; // Полубайты.
+                bits >>= 4;
+                left--;
+            }
+        }
+        rsexh::Matrix<int> v;
+        code.EncodeBlock(a, v);
+        channel(v);
+        hamming::CodeWord<int, M2> decoded;
+        int erased;
+        code.DecodeBlock(v, decoded, erased);
+        counts.mBlocks++;
+        counts.mBits += K * M2 * 4;
+        long long errors = 0;
+        for (int k = 0; k < K && k < int(decoded.size()); ++k) {
+            if (decoded[k].mStatus != hamming::SymbolStatus::Normal) {
+                errors += (M2 * 4) / 2; // Стертый символ: эквивалентная вероятность ошибки бита 0.5.
+                continue;
+            }
+            for (int j = 0; j < M2; ++j)
+                errors += std::popcount(unsigned(a[k].mSymbol[j] ^ decoded[k].mSymbol[j]));
+        }
+        if (int(decoded.size()) < K)
+            errors += (K - int(decoded.size())) * (M2 * 4) / 2;
+        counts.mBitErrors += errors;
+        counts.mBlockErrors += errors != 0;
+        return errors;
+    }
+
+    /**
+     * Смоделировать блоки [mFirstBlock, mFirstBlock + mBlocks) в канале model. Каждый поток работает со своей копией
+     * кода (декодер хранит промежуточное состояние); таблицы поля Галуа разделяются только на чтение.
+     */
+    template <typename Code, channel::Model Channel>
+    Result Run(const Code& prototype, const Config& config, const Channel& model)
+    {
+        const int threads = config.mThreads > 0 ? config.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<long long> next{0};
+        std::atomic<long long> blocks{0};
+        std::atomic<long long> bits{0};
+        std::atomic<long long> bit_errors{0};
+        std::atomic<long long> block_errors{0};
+        auto worker = [&] {
+            Code code = prototype;
+            for (;;) {
+                const long long begin = next.fetch_add(config.mChunk, std::memory_order_relaxed);
+                if (begin >= config.mBlocks)
+                    break;
+                const long long end = std::min<long long>(begin + config.mChunk, config.mBlocks);
+                Result local;
+                for (long long b = begin; b < end; ++b) {
+                    CounterRng rng{config.mSeed, uint64_t(config.mFirstBlock + b)};
+                    SimulateBlock(code, rng, [&](rsexh::Matrix<int>& v) {
+                        channel::WordsTarget target{v};
+                        model.Apply(target.Symbols(), rng, target);
+                    }, local);
+                }
+                blocks.fetch_add(local.mBlocks, std::memory_order_relaxed);
+                bits.fetch_add(local.mBits, std::memory_order_relaxed);
+                bit_errors.fetch_add(local.mBitErrors, std::memory_order_relaxed);
+                block_errors.fetch_add(local.mBlockErrors, std::memory_order_relaxed);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool)
+            t.join();
+        Result result;
+        result.mBlocks = blocks;
+        result.mBits = bits;
+        result.mBitErrors = bit_errors;
+        result.mBlockErrors = block_errors;
+        return result;
+    }
+
+    /**
+     * Двоичный симметричный канал с вероятностью ошибки config.mBer.
+     */
+    template <typename Code>
+    Result Run(const Code& prototype, const Config& config)
+    {
+        return Run(prototype, config, channel::Bsc{config.mBer});
+    }
+
+    /**
+     * Внести ровно weight ошибок в случайные различные биты слова РС (алгоритм Флойда).
+     * При заданном весе все расположения ошибок двоичного симметричного канала равновероятны.
+     */
+    inline void InjectWord(std::vector<int>& word, int weight, CounterRng& rng)
+    {
+        constexpr int kBits = 4;
+        const int total = static_cast<int>(word.size()) * kBits;
+        int chosen[64];
+        assert(weight <= 64);
+        int count = 0;
+        for (int j = total - weight; j < total; ++j) {
+            const int t = static_cast<int>((static_cast<unsigned __int128>(rng.Next()) * uint64_t(j + 1)) >> 64);
+            const bool is_taken = std::find(chosen, chosen + count, t) != chosen + count;
+            chosen[count++] = is_taken ? j : t;
+        }
+        for (int i = 0; i < count; ++i)
+            word[chosen[i] / kBits] ^= 1 << (chosen[i] % kBits);
+    }
+
+    /**
+     * Интервал Уилсона для доли k из n: устойчив и при k = 0.
+     */
+    inline void WilsonInterval(long long k, long long n, double z, double& low, double& high)
+    {
+        if (n == 0) {
+            low = 0.;
+            high = 1.;
+            return;
+        }
+        const double f = (1. * k) / n;
+        const double z2 = z * z;
+        const double center = (f + z2 / (2. * n)) / (1. + z2 / n);
+        const double delta = z * std::sqrt(f * (1. - f) / n + z2 / (4. * n * n)) / (1. + z2 / n);
+        low = k == 0 ? 0. : std::max(0., center - delta);
+        high = std::min(1., center + delta);
+    }
+
+    struct ImportanceConfig
+    {
+        double mBer = 1.e-3;             // Вероятность ошибки бита в канале.
+        long long mBlocksPerLayer = 200; // Блоков на слой в среднем: слои получают их пропорционально вероятности,
+                                         // но не меньше четверти.
+        int mMaxHeavy = 0;               // Наибольшее число тяжелых слов; 0 - по mTailBound.
+        double mTailBound = 1.e-15;      // Допустимая вероятность отброшенного хвоста.
+        double mZ = 1.96;                // Квантиль нормального распределения для доверительного интервала.
+        uint64_t mSeed = 1;
+        int mThreads = 0;
+        int mChunk = 16;
+    };
+
+    struct ImportanceResult
+    {
+        double mBer = 0.;       // Оценка BER на выходе декодера.
+        double mBerLow = 0.;    // Доверительный интервал BER.
+        double mBerHigh = 0.;
+        double mFer = 0.;       // Оценка вероятности ошибки блока.
+        double mFerLow = 0.;
+        double mFerHigh = 0.;
+        double mTail = 0.;      // Вероятность не смоделированных исходов (добавлена к верхним границам).
+        int mMaxHeavy = 0;      // Смоделированные слои: 1..mMaxHeavy тяжелых слов РС.
+        int mMaxErrors = 0;     // Наибольшее число ошибок в тяжелом слове.
+        long long mBlocks = 0;  // Смоделировано блоков.
+    };
+
+    /**
+     * Выборка по значимости с группировкой ошибок по словам РС. Слово из b бит с числом ошибок c
+     * не больше глубины исправления t (CorrectionMode) всегда исправляется, а отказ блока требует
+     * тяжелых слов (c > t): ложного исправления одного слова или стирания нескольких. Поэтому:
+     * - слой h - ровно h тяжелых слов из W, вероятность слоя P(H = h) = C(W, h) eta^h (1 - eta)^(W - h),
+     *   где eta = P(c > t); слой h = 0 безошибочен и не моделируется;
+     * - число ошибок первого тяжелого слова берется не из f(c | c > t), а из смеси
+     *   g = (f(c | c > t) + f(c | c > t + 1)) / 2: ложное исправление требует больше t + 1 ошибок, и такие
+     *   слова встречаются в половине блоков, а не с вероятностью порядка p; испытание взвешивается
+     *   отношением правдоподобия f(c | c > t) / g(c) (не больше 2). Остальные тяжелые слова (отказ
+     *   из-за стираний) - из f(c | c > t);
+     * - легкие слова и расположение ошибок внутри слова - из исходного распределения.
+     * Оценка - сумма P(H = h) * (среднее взвешенных исходов слоя), интервал слоя - нормальный по выборочной
+     * дисперсии; слой без отказов дает верхнюю границу 2 * (граница Уилсона для нуля отказов).
+     * Блоки распределяются по слоям пропорционально P(H = h) (не меньше четверти среднего на слой).
+     * Результат детерминирован при заданном зерне (поток генератора - слой и номер блока в слое).
+     */
+    template <typename Code>
+    ImportanceResult RunImportance(const Code& prototype, const ImportanceConfig& config)
+    {
+        const int words = prototype.mHammingCode.N;
+        const int b = Code::N * 4;
+        const double info_bits = static_cast<double>(prototype.mHammingCode.K) * Code::M2 * 4;
+        const double p = config.mBer;
+        const int t = static_cast<int>(prototype.mMode);
+        auto binomial = [](int n, int k, double x) {
+            if (x <= 0. || x >= 1.)
+                return (k == 0 && x <= 0.) || (k == n && x >= 1.) ? 1. : 0.;
+            return std::exp(std::lgamma(n + 1.) - std::lgamma(k + 1.) - std::lgamma(n - k + 1.) +
+                            k * std::log(x) + (n - k) * std::log1p(-x));
+        };
+        // Распределение числа ошибок в слове: f(c) и хвост P(c' > c), суммированный сверху для точности.
+        std::vector<double> f(b + 1);
+        for (int c = 0; c <= b; ++c)
+            f[c] = binomial(b, c, p);
+        std::vector<double> f_tail(b + 1, 0.);
+        for (int c = b - 1; c >= 0; --c)
+            f_tail[c] = f_tail[c + 1] + f[c + 1];
+        const double eta = f_tail[t];
+        if (!(eta > 0.))
+            return ImportanceResult{}; // Тяжелых слов не бывает: отказов нет.
+        double light = 0.;
+        for (int c = 0; c <= t; ++c)
+            light += f[c];
+        int max_errors = t + 2;
+        while (max_errors < b && words * f_tail[max_errors] > config.mTailBound)
+            max_errors++;
+        // Слои: P(H = h) и хвост P(H > h).
+        std::vector<double> layer(words + 1);
+        for (int h = 0; h <= words; ++h)
+            layer[h] = binomial(words, h, eta);
+        std::vector<double> layer_tail(words + 1, 0.);
+        for (int h = words - 1; h >= 0; --h)
+            layer_tail[h] = layer_tail[h + 1] + layer[h + 1];
+        int max_heavy = config.mMaxHeavy;
+        if (max_heavy <= 0) {
+            max_heavy = 1;
+            while (max_heavy < words && layer_tail[max_heavy] > config.mTailBound)
+                max_heavy++;
+        }
+        max_heavy = std::min(max_heavy, words);
+
+        // Смещенное распределение тяжелого слова g и его обратная функция распределения.
+        const double heavy = f_tail[t] - f_tail[max_errors];
+        const double heavier = f_tail[t + 1] - f_tail[max_errors];
+        std::vector<double> g(max_errors + 1, 0.);
+        std::vector<double> g_cdf(max_errors + 1, 0.);
+        std::vector<double> heavy_cdf(max_errors + 1, 0.);
+        for (int c = t + 1; c <= max_errors; ++c) {
+            g[c] = 0.5 * f[c] / heavy + (c > t + 1 && heavier > 0. ? 0.5 * f[c] / heavier : 0.);
+            g_cdf[c] = g_cdf[c - 1] + g[c];
+            heavy_cdf[c] = heavy_cdf[c - 1] + f[c] / heavy;
+        }
+        std::vector<double> light_cdf(t + 1, 0.);
+        for (int c = 0; c <= t; ++c)
+            light_cdf[c] = (c > 0 ? light_cdf[c - 1] : 0.) + f[c] / light;
+        auto draw = [](const std::vector<double>& cdf, int first, double u) {
+            int c = first;
+            while (c + 1 < int(cdf.size()) && cdf[c] < u * cdf.back())
+                c++;
+            return c;
+        };
+
+        // Испытания слоя h - [first[h], first[h + 1]): пропорционально P(H = h), но не меньше четверти среднего.
+        const long long per_layer = config.mBlocksPerLayer;
+        double mass = 0.;
+        for (int h = 1; h <= max_heavy; ++h)
+            mass += layer[h];
+        std::vector<long long> first(max_heavy + 2, 0);
+        for (int h = 1; h <= max_heavy; ++h) {
+            const long long share = std::llround(per_layer * max_heavy * layer[h] / mass);
+            first[h + 1] = first[h] + std::max({share, per_layer / 4, 2LL});
+        }
+        const long long jobs = first[max_heavy + 1];
+        // Взвешенные ошибочные биты и взвешенный отказ каждого испытания: суммы по слоям считаются
+        // в порядке испытаний, поэтому не зависят от числа потоков.
+        std::vector<double> weighted_errors(jobs, 0.);
+        std::vector<double> weighted_failures(jobs, 0.);
+        std::vector<char> is_failed(jobs, 0);
+        std::atomic<long long> next{0};
+        auto worker = [&] {
+            Code code = prototype;
+            std::vector<int> heavy_words;
+            for (;;) {
+                const long long begin = next.fetch_add(config.mChunk, std::memory_order_relaxed);
+                if (begin >= jobs)
+                    break;
+                const long long end = std::min<long long>(begin + config.mChunk, jobs);
+                for (long long job = begin; job < end; ++job) {
+                    const int h = int(std::upper_bound(first.begin() + 1, first.end(), job) - first.begin()) - 1;
+                    CounterRng rng{config.mSeed, (uint64_t(h) << 40) | uint64_t(job - first[h])};
+                    double weight = 1.;
+                    Result counts;
+                    const long long x = SimulateBlock(code, rng, [&](rsexh::Matrix<int>& v) {
+                        heavy_words.clear();
+                        for (int j = words - h; j < words; ++j) { // Алгоритм Флойда: h различных слов.
+                            const int r = static_cast<int>((static_cast<unsigned __int128>(rng.Next()) * uint64_t(j + 1)) >> 64);
+                            const bool is_taken = std::find(heavy_words.begin(), heavy_words.end(), r) != heavy_words.end();
+                            heavy_words.push_back(is_taken ? j : r);
+                        }
+                        for (int i = 0; i < words; ++i) {
+                            const auto it = std::find(heavy_words.begin(), heavy_words.end(), i);
+                            int c;
+                            if (it == heavy_words.begin()) { // Первое тяжелое слово - из смеси g.
+                                c = draw(g_cdf, t + 1, rng.Uniform());
+                                weight = f[c] / heavy / g[c];
+                            } else if (it != heavy_words.end()) {
+                                c = draw(heavy_cdf, t + 1, rng.Uniform());
+                            } else {
+                                c = draw(light_cdf, 0, rng.Uniform());
+                            }
+                            InjectWord(v[i], c, rng);
+                        }
+                    }, counts);
+                    weighted_errors[job] = weight * x;
+                    weighted_failures[job] = x != 0 ? weight : 0.;
+                    is_failed[job] = x != 0;
+                }
+            }
+        };
+        const int threads = config.mThreads > 0 ? config.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool)
+            thread.join();
+
+        ImportanceResult result;
+        result.mMaxHeavy = max_heavy;
+        result.mMaxErrors = max_errors;
+        result.mBlocks = jobs;
+        result.mTail = layer_tail[max_heavy] + words * f_tail[max_errors];
+        // Ошибочных бит на отказавший блок (по всем слоям) - для слоев без единого отказа.
+        double total_errors = 0.;
+        long long total_failed = 0;
+        for (long long job = 0; job < jobs; ++job) {
+            total_errors += is_failed[job] ? weighted_errors[job] / weighted_failures[job] : 0.;
+            total_failed += is_failed[job];
+        }
+        const double bits_per_failure = total_failed > 0 ? total_errors / total_failed : info_bits;
+        for (int h = 1; h <= max_heavy; ++h) {
+            double sum_x = 0., sum_x2 = 0., sum_y = 0., sum_y2 = 0.;
+            long long failed = 0;
+            const long long blocks = first[h + 1] - first[h];
+            const double m = static_cast<double>(blocks);
+            for (long long job = first[h]; job < first[h + 1]; ++job) {
+                const double x = weighted_errors[job];
+                const double y = weighted_failures[job];
+                sum_x += x;
+                sum_x2 += x * x;
+                sum_y += y;
+                sum_y2 += y * y;
+                failed += is_failed[job];
+            }
+            const double mean_x = sum_x / m;
+            const double mean_y = sum_y / m;
+            result.mBer += layer[h] * mean_x / info_bits;
+            result.mFer += layer[h] * mean_y;
+            if (failed == 0) {
+                // Отказов нет: доля отказов не выше границы Уилсона, вес испытания не больше 2.
+                double low = 0.;
+                double high = 1.;
+                WilsonInterval(0, blocks, config.mZ, low, high);
+                const double fer_high = std::min(1., 2. * high);
+                result.mFerHigh += layer[h] * fer_high;
+                result.mBerHigh += layer[h] * fer_high * bits_per_failure / info_bits;
+                continue;
+            }
+            auto delta = [&](double sum2, double mean) {
+                if (blocks < 2)
+                    return mean;
+                const double s2 = std::max(0., (sum2 - m * mean * mean) / (m - 1.));
+                return config.mZ * std::sqrt(s2 / m);
+            };
+            const double delta_x = delta(sum_x2, mean_x);
+            const double delta_y = delta(sum_y2, mean_y);
+            result.mBerLow += layer[h] * std::max(0., mean_x - delta_x) / info_bits;
+            result.mBerHigh += layer[h] * (mean_x + delta_x) / info_bits;
+            result.mFerLow += layer[h] * std::max(0., mean_y - delta_y);
+            result.mFerHigh += layer[h] * std::min(1., mean_y + delta_y);
+        }
+        result.mBerHigh += result.mTail;
+        result.mFerHigh += result.mTail;
+        return result;
+    }
+
+} // namespace sim
@@ -0,0 +1,338 @@
+/**
+ * Потоковый (скользящее окно) код восстановления стертых символов.
+ * Альтернатива блочному внешнему коду: восстанавливающие символы покрывают скользящее окно
+ * последних W информационных символов, и потеря восстанавливается, как только накопилось
+ * достаточно уравнений, без ожидания конца блока. Алгебра та же - XOR кодовых элементов.
+ */
+
+#pragma once
+
+#include <cstdint>    // uint32_t
+#include <vector>     // std::vector
+#include <map>        // std::map
+#include <algorithm>  // std::set_symmetric_difference
+#include <iterator>   // std::back_inserter
+#include <functional> // std::function
+#include "hamming.hpp"
+
+namespace sliding {
+
+    /**
+     * Пакет потокового кода: информационный символ с номером mSeq, либо восстанавливающий символ -
+     * сумма символов окна [mFirst, mSeq] с двоичными коэффициентами, заданными номером mRepairId.
+     * Последние mFresh символов окна (поступившие после предыдущего восстанавливающего) входят всегда.
+     */
+    template <typename T, int M>
+    struct Packet
+    {
+        bool mIsRepair = false;
+        uint32_t mSeq = 0;
+        uint32_t mFirst = 0;
+        uint32_t mRepairId = 0;
+        uint32_t mFresh = 1;
+        hamming::CodeElement< T, M > mElement{hamming::SymbolStatus::Normal, {}};
+    };
+
+    /**
+     * Порядок номеров с учетом переполнения: a раньше b, если int32_t(a - b) < 0. Номера символов,
+     * одновременно находящихся в декодере, отстоят меньше чем на 2^31, поэтому порядок на них строгий.
+     */
+    struct SeqLess
+    {
+        bool operator()(uint32_t a, uint32_t b) const { return int32_t(a - b) < 0; }
+    };
+
+    /**
+     * Коэффициент при символе seq в восстанавливающем символе repair_id. Последние fresh символов окна
+     * входят всегда - так каждый символ покрыт хотя бы одним уравнением; остальные - псевдослучайно
+     * с вероятностью 1/2 (одинаково у кодера и декодера).
+     */
+    inline bool Coefficient(uint32_t repair_id, uint32_t seq, uint32_t last, uint32_t fresh)
+    {
+        if (last - seq < fresh) {
+            return true;
+        }
+        uint64_t x = (uint64_t(repair_id) << 32) | seq;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x & 1;
+    }
+
+    /**
+     * Кодер: после каждых Interval информационных символов выдает восстанавливающий символ по окну из W последних.
+     * Избыточность - 1/Interval. Память - кольцевой буфер окна.
+     */
+    template <typename T, int M>
+    class Encoder
+    {
+    public:
+        using Send = std::function<void(const Packet< T, M >&)>;
+
+        /**
+         * @param first_seq Номер первого символа (номера идут по модулю 2^32).
+         */
+        Encoder(int window, int interval, Send send, uint32_t first_seq = 0)
+            : mWindow{window}, mInterval{interval}, mSend{std::move(send)}, mRing(window), mSeq{first_seq}
+        {
+            assert(window > 0 && interval > 0);
+        }
+
+        void Add(const hamming::CodeElement< T, M >& element)
+        {
+            assert(element.mStatus == hamming::SymbolStatus::Normal);
+            // Ячейка кольца - по счетчику символов, а не по номеру: 2^32 не кратно окну.
+            mRing[mAdded % mWindow] = element;
+            mPacket.mIsRepair = false;
+            mPacket.mSeq = mSeq;
+            mPacket.mFirst = mSeq;
+            mPacket.mElement = element;
+            mSend(mPacket);
+            if ((mAdded + 1) % mInterval == 0) {
+                const uint64_t span = std::min<uint64_t>(mAdded + 1, mWindow);
+                mPacket.mIsRepair = true;
+                mPacket.mFirst = mSeq - uint32_t(span - 1);
+                mPacket.mRepairId = mRepairId;
+                mPacket.mFresh = mInterval;
+                mPacket.mElement = {hamming::SymbolStatus::Normal, {}};
+                for (uint64_t i = mAdded + 1 - span; i <= mAdded; ++i) {
+                    const uint32_t s = mSeq - uint32_t(mAdded - i);
+                    if (Coefficient(mRepairId, s, mSeq, mInterval))
+                        mPacket.mElement += mRing[i % mWindow];
+                }
+                mSend(mPacket);
+                mRepairId++;
+            }
+            mSeq++;
+            mAdded++;
+        }
+
+    private:
+        int mWindow;
+        int mInterval;
+        Send mSend;
+        std::vector< hamming::CodeElement< T, M > > mRing;
+        Packet< T, M > mPacket;
+        uint32_t mSeq = 0;
+        uint64_t mAdded = 0; // Символов добавлено.
+        uint32_t mRepairId = 0;
+    };
+
+    /**
+     * Статистика декодера. Задержка доставки измеряется в символах: насколько номер самого нового
+     * принятого символа опережал номер доставляемого.
+     */
+    struct DecoderStats
+    {
+        long long mDelivered = 0;
+        long long mRecovered = 0;
+        long long mLost = 0;
+        long long mDelaySum = 0;
+        long long mMaxDelay = 0;
+    };
+
+    /**
+     * Декодер: доставляет символы строго по порядку. Уравнения восстанавливающих символов хранятся
+     * в ступенчатом виде (метод Гаусса над GF(2) выполняется по мере поступления уравнений);
+     * символ объявляется потерянным, если номер самого нового принятого символа опередил его на max_delay.
+     */
+    template <typename T, int M>
+    class Decoder
+    {
+    public:
+        using Element = hamming::CodeElement< T, M >;
+        using Deliver = std::function<void(uint32_t seq, const Element* element)>; // nullptr - символ потерян.
+
+        /**
+         * @param first_seq Номер первого символа потока (как у кодера).
+         */
+        Decoder(int window, int max_delay, Deliver deliver, uint32_t first_seq = 0)
+            : mWindow{window}, mMaxDelay{max_delay}, mDeliver{std::move(deliver)}, mNextDeliver{first_seq}
+        {
+            assert(max_delay >= window);
+        }
+
+        void Receive(const Packet< T, M >& packet)
+        {
+            if (!mHasHighest || int32_t(packet.mSeq - mHighest) > 0) {
+                mHighest = packet.mSeq;
+                mHasHighest = true;
+            }
+            if (!packet.mIsRepair) {
+                if (int32_t(packet.mSeq - mNextDeliver) >= 0 && !mKnown.contains(packet.mSeq)) {
+                    Learn(packet.mSeq, packet.mElement, false);
+                }
+            } else {
+                Equation eq;
+                eq.mRhs = packet.mElement;
+                for (uint32_t s = packet.mFirst; int32_t(s - packet.mSeq) <= 0; ++s) {
+                    if (Coefficient(packet.mRepairId, s, packet.mSeq, packet.mFresh))
+                        eq.mUnknowns.push_back(s);
+                }
+                if (Substitute(eq)) {
+                    Insert(std::move(eq));
+                }
+            }
+            DeliverInOrder();
+        }
+
+        /**
+         * Конец потока: доставить все, что можно, остальное до самого нового символа объявить потерянным.
+         */
+        void Flush()
+        {
+            DeliverInOrder();
+            while (mHasHighest && int32_t(mHighest - mNextDeliver) >= 0) {
+                DeliverNext();
+            }
+        }
+
+        const DecoderStats& Stats() const { return mStats; }
+
+    private:
+        /**
+         * Уравнение: сумма неизвестных символов (номера упорядочены по SeqLess) равна mRhs.
+         */
+        struct Equation
+        {
+            std::vector<uint32_t> mUnknowns;
+            Element mRhs{hamming::SymbolStatus::Normal, {}};
+        };
+
+        /**
+         * Исключить из уравнения известные символы. false - уравнение бесполезно
+         * (неизвестных не осталось, либо в нем есть уже доставленный как потерянный символ).
+         */
+        bool Substitute(Equation& eq) const
+        {
+            std::vector<uint32_t> unknowns;
+            for (auto s : eq.mUnknowns) {
+                if (auto it = mKnown.find(s); it != mKnown.end()) {
+                    eq.mRhs += it->second;
+                } else if (int32_t(s - mNextDeliver) < 0) {
+                    return false;
+                } else {
+                    unknowns.push_back(s);
+                }
+            }
+            eq.mUnknowns = std::move(unknowns);
+            return !eq.mUnknowns.empty();
+        }
+
+        /**
+         * Вставить уравнение в ступенчатую систему (ведущий элемент - самый ранний номер неизвестного).
+         */
+        void Insert(Equation eq)
+        {
+            while (!eq.mUnknowns.empty()) {
+                auto it = mPivots.find(eq.mUnknowns.front());
+                if (it == mPivots.end()) {
+                    break;
+                }
+                std::vector<uint32_t> diff;
+                std::set_symmetric_difference(eq.mUnknowns.begin(), eq.mUnknowns.end(),
+                                              it->second.mUnknowns.begin(), it->second.mUnknowns.end(),
+                                              std::back_inserter(diff), SeqLess{});
+                eq.mUnknowns = std::move(diff);
+                eq.mRhs += it->second.mRhs;
+            }
+            if (eq.mUnknowns.empty()) {
+                return; // Линейно зависимое уравнение.
+            }
+            if (eq.mUnknowns.size() == 1) {
+                Learn(eq.mUnknowns.front(), eq.mRhs, true);
+                return;
+            }
+            const uint32_t pivot = eq.mUnknowns.front();
+            mPivots.emplace(pivot, std::move(eq));
+        }
+
+        /**
+         * Символ стал известен: запомнить и исключить его из всех уравнений; уравнения,
+         * потерявшие ведущий элемент или ставшие одиночными, вставляются заново (каскад).
+         */
+        void Learn(uint32_t seq, const Element& element, bool recovered)
+        {
+            std::vector<std::pair<uint32_t, bool>> pending{{seq, recovered}};
+            std::vector<Element> values{element};
+            while (!pending.empty()) {
+                const auto [s, is_recovered] = pending.back();
+                const Element value = values.back();
+                pending.pop_back();
+                values.pop_back();
+                if (mKnown.contains(s)) {
+                    continue;
+                }
+                mKnown.emplace(s, value);
+                mStats.mRecovered += is_recovered;
+                std::vector<Equation> touched;
+                for (auto it = mPivots.begin(); it != mPivots.end();) {
+                    if (std::binary_search(it->second.mUnknowns.begin(), it->second.mUnknowns.end(), s, SeqLess{})) {
+                        touched.push_back(std::move(it->second));
+                        it = mPivots.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                for (auto& eq : touched) {
+                    if (!Substitute(eq)) {
+                        continue;
+                    }
+                    if (eq.mUnknowns.size() == 1) {
+                        pending.emplace_back(eq.mUnknowns.front(), true);
+                        values.push_back(eq.mRhs);
+                        continue;
+                    }
+                    Insert(std::move(eq));
+                }
+            }
+        }
+
+        void DeliverNext()
+        {
+            const long long delay = int32_t(mHighest - mNextDeliver);
+            if (auto it = mKnown.find(mNextDeliver); it != mKnown.end()) {
+                mDeliver(mNextDeliver, &it->second);
+                mStats.mDelivered++;
+                mStats.mDelaySum += delay;
+                mStats.mMaxDelay = std::max(mStats.mMaxDelay, delay);
+            } else {
+                mDeliver(mNextDeliver, nullptr);
+                mStats.mLost++;
+                // Уравнения с потерянным символом больше не нужны.
+                for (auto it = mPivots.begin(); it != mPivots.end();) {
+                    it = it->second.mUnknowns.front() == mNextDeliver ? mPivots.erase(it) : std::next(it);
+                }
+            }
+            mNextDeliver++;
+            // Символы старше окна уже не входят ни в одно новое уравнение.
+            while (!mKnown.empty() && int32_t(mNextDeliver - mKnown.begin()->first) > mWindow) {
+                mKnown.erase(mKnown.begin());
+            }
+        }
+
+        void DeliverInOrder()
+        {
+            while (mHasHighest && int32_t(mHighest - mNextDeliver) >= 0) {
+                const bool is_known = mKnown.contains(mNextDeliver);
+                if (!is_known && int32_t(mHighest - mNextDeliver) < mMaxDelay) {
+                    break;
+                }
+                DeliverNext();
+            }
+        }
+
+        int mWindow;
+        int mMaxDelay;
+        Deliver mDeliver;
+        std::map<uint32_t, Element, SeqLess> mKnown;
+        std::map<uint32_t, Equation, SeqLess> mPivots;
+        uint32_t mNextDeliver = 0;
+        uint32_t mHighest = 0;
+        bool mHasHighest = false;
+        DecoderStats mStats;
+    };
+
+} // namespace sliding
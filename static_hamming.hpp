@@ -0,0 +1,331 @@
+/**
+ * Внешний код с проверочной матрицей, заданной на этапе компиляции (параметр шаблона).
+ * Систематическая форма матрицы и уравнения восстановления одного стертого символа вычисляются
+ * при компиляции, поэтому кодирование, синдром и восстановление - развернутые последовательности XOR
+ * без ветвлений и без обращений к матрице во время работы.
+ */
+
+#pragma once
+
+#include <cstdint>  // uint8_t
+#include <array>    // std::array
+#include <utility>  // std::index_sequence, std::pair
+#include <bit>      // std::countr_zero
+#include "hamming.hpp"
+
+namespace hamming {
+
+    /**
+     * Проверочная матрица, пригодная как параметр шаблона.
+     */
+    template <int R, int N>
+    using ParityMatrix = std::array<std::array<uint8_t, N>, R>;
+
+    /**
+     * Проверочная матрица расширенного кода Хэмминга, та же, что по умолчанию в HammingExtended.
+     */
+    template <int R>
+    constexpr ParityMatrix<R, power2<int>(R - 1)> ExtendedHammingMatrix()
+    {
+        constexpr int N = power2<int>(R - 1);
+        ParityMatrix<R, N> H{};
+        for (int j = 0; j < N; ++j)
+            H[0][j] = 1;
+        int deg = N / 2;
+        for (int i = 1; i < R; ++i) {
+            for (int j = 0; j < N; ++j)
+                H[i][j] = (((j + 1) / deg) % 2) == 1;
+            deg /= 2;
+        }
+        return H;
+    }
+
+    /**
+     * Проверочная матрица кода Голея (23, 12), циклический, кодовое расстояние - 7.
+     */
+    inline constexpr ParityMatrix<11, 23> kGolayParityMatrix{{
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0},
+        {0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0},
+        {0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0},
+        {0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+        {1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    }};
+
+    /**
+     * Матрица времени компиляции в виде, принимаемом конструктором HammingExtended.
+     */
+    template <std::size_t R, std::size_t N>
+    inline Matrix<int> ToMatrix(const std::array<std::array<uint8_t, N>, R>& H)
+    {
+        Matrix<int> result(R, std::vector<int>(N));
+        for (std::size_t i = 0; i < R; ++i) {
+            for (std::size_t j = 0; j < N; ++j)
+                result[i][j] = H[i][j];
+        }
+        return result;
+    }
+
+    /**
+     * Систематическая форма проверочной матрицы и сделанные перестановки столбцов.
+     */
+    template <int R, int N>
+    struct SystematicForm
+    {
+        ParityMatrix<R, N> mHsys{};
+        std::array<std::pair<int, int>, R> mSwaps{};
+        int mSwapCount = 0;
+        bool mIsOk = true;
+    };
+
+    /**
+     * То же преобразование, что MakeParityMatrixSystematic (базисные столбцы - справа), но при компиляции.
+     */
+    template <int R, int N>
+    constexpr SystematicForm<R, N> MakeSystematicForm(const ParityMatrix<R, N>& H)
+    {
+        SystematicForm<R, N> form;
+        auto& h = form.mHsys;
+        h = H;
+        auto add_row = [&h](int dst, int src) {
+            for (int k = 0; k < N; ++k)
+                h[dst][k] ^= h[src][k];
+        };
+        // Формирование верхней треугольной матрицы (справа).
+        for (int i = R - 1; i >= 0; --i) {
+            const int column = N - R + i;
+            bool has_lead = h[i][column] != 0;
+            for (int j = i - 1; j >= 0 && !has_lead; --j) {
+                if (h[j][column] != 0) {
+                    add_row(i, j);
+                    has_lead = true;
+                }
+            }
+            if (!has_lead) {
+                std::pair<int, int> swap{-1, -1};
+                for (int j = 0; j < N - R; ++j) {
+                    if (h[i][j] != 0) {
+                        for (int k = 0; k < R; ++k) {
+                            const auto x = h[k][column];
+                            h[k][column] = h[k][j];
+                            h[k][j] = x;
+                        }
+                        swap = {column, j};
+                        has_lead = true;
+                        break;
+                    }
+                }
+                form.mSwaps[form.mSwapCount++] = swap;
+            }
+            form.mIsOk &= has_lead;
+            for (int j = i - 1; j >= 0; --j) {
+                if (h[j][column] != 0)
+                    add_row(j, i);
+            }
+        }
+        // Формирование нижней треугольной матрицы (справа).
+        for (int i = 0; i < R; ++i) {
+            for (int j = i + 1; j < R; ++j) {
+                if (h[j][N - R + i] != 0)
+                    add_row(j, i);
+            }
+        }
+        return form;
+    }
+
+    /**
+     * Для каждого символа - кодовое слово дуального кода наименьшего веса, содержащее его
+     * (при R > 12 - только строки систематической матрицы).
+     */
+    template <int R, int N>
+    constexpr std::array<std::array<uint8_t, N>, N> MakeSingleCovers(const ParityMatrix<R, N>& Hsys)
+    {
+        std::array<std::array<uint8_t, N>, N> covers{};
+        std::array<int, N> best{};
+        best.fill(N + 1);
+        std::array<uint8_t, N> row{};
+        const int combinations = R <= 12 ? (1 << R) : R + 1;
+        for (int c = 1; c < combinations; ++c) {
+            if (R <= 12) {
+                const int bit = std::countr_zero(unsigned(c));
+                for (int i = 0; i < N; ++i)
+                    row[i] ^= Hsys[bit][i];
+            } else {
+                row = Hsys[c - 1];
+            }
+            int weight = 0;
+            for (int i = 0; i < N; ++i)
+                weight += row[i];
+            for (int e = 0; e < N; ++e) {
+                if (row[e] != 0 && weight < best[e]) {
+                    best[e] = weight;
+                    covers[e] = row;
+                }
+            }
+        }
+        return covers;
+    }
+
+    /**
+     * Перестановка столбцов систематической формы в порядок исходной матрицы H: символ систематического
+     * слова с номером order[p] стоит на позиции p (те же перестановки, что HammingExtended::Encode
+     * в несистематическом режиме).
+     */
+    template <int R, int N>
+    constexpr std::array<int, N> MakeColumnOrder(const SystematicForm<R, N>& form)
+    {
+        std::array<int, N> order{};
+        for (int p = 0; p < N; ++p)
+            order[p] = p;
+        for (int i = 0; i < form.mSwapCount; ++i) {
+            const auto [a, b] = form.mSwaps[i];
+            if (a < 0)
+                continue;
+            const int x = order[a];
+            order[a] = order[b];
+            order[b] = x;
+        }
+        return order;
+    }
+
+    /**
+     * Внешний код с проверочной матрицей H времени компиляции: кодовые слова - те же, что у
+     * HammingExtended< T, R, M >{H} после SwitchToSystematic(false), то есть слова кода H.
+     * Если систематическая форма получена без перестановок столбцов, информационные символы - первые K,
+     * иначе - на позициях InformationPosition(k). Символы - CodeElement< T, M >, стирания
+     * не поддерживаются (кроме RepairSingle).
+     */
+    template <typename T, int M, auto H>
+    struct StaticCode
+    {
+        static constexpr int R = H.size();
+        static constexpr int N = H[0].size();
+        static constexpr int K = N - R;
+        static constexpr auto kForm = MakeSystematicForm<R, N>(H);
+        static_assert(kForm.mIsOk, "Parity-check matrix has no systematic form");
+        static constexpr auto kOrder = MakeColumnOrder<R, N>(kForm);
+        static constexpr auto kPositions = [] {
+            std::array<int, N> positions{};
+            for (int p = 0; p < N; ++p)
+                positions[kOrder[p]] = p;
+            return positions;
+        }();
+        // Систематическая матрица со столбцами в порядке H: синдром и восстановление - в позициях кода H.
+        static constexpr auto kH = [] {
+            ParityMatrix<R, N> h{};
+            for (int i = 0; i < R; ++i) {
+                for (int p = 0; p < N; ++p)
+                    h[i][p] = kForm.mHsys[i][kOrder[p]];
+            }
+            return h;
+        }();
+        static constexpr auto kCovers = MakeSingleCovers<R, N>(kH);
+
+        using Element = CodeElement< T, M >;
+
+        /**
+         * Позиция информационного символа k в кодовом слове.
+         */
+        static constexpr int InformationPosition(int k) { return kPositions[k]; }
+
+        /**
+         * Закодировать K информационных символов a в N символов v.
+         */
+        static void Encode(const Element* a, Element* v)
+        {
+            for (int k = 0; k < K; ++k)
+                v[kPositions[k]] = a[k];
+            [&]<std::size_t... Row>(std::index_sequence<Row...>) {
+                (SumRow<kForm.mHsys, Row>(a, v[kPositions[K + Row]], std::make_index_sequence<K>{}), ...);
+            }(std::make_index_sequence<R>{});
+        }
+
+        /**
+         * Синдром принятого вектора v (N символов без стираний) - R символов s.
+         */
+        static void Syndrome(const Element* v, Element* s)
+        {
+            [&]<std::size_t... Row>(std::index_sequence<Row...>) {
+                (SumRow<kH, Row>(v, s[Row], std::make_index_sequence<N>{}), ...);
+            }(std::make_index_sequence<R>{});
+        }
+
+        /**
+         * Признак кодового слова: нулевой синдром.
+         */
+        static bool IsCodeword(const Element* v)
+        {
+            std::array<Element, R> s;
+            Syndrome(v, s.data());
+            for (const auto& el : s) {
+                for (const auto x : el.mSymbol) {
+                    if (x != 0)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Восстановить единственный стертый символ e вектора v (N символов).
+         */
+        static void RepairSingle(Element* v, int e)
+        {
+            kRepair[e](v);
+        }
+
+    private:
+        static void Xor(std::array< T, M >& dst, const std::array< T, M >& src)
+        {
+            XorInto(dst, src);
+        }
+
+        /**
+         * out = сумма символов v[Col] с единицами в строке Row матрицы Rows.
+         */
+        template <const auto& Rows, std::size_t Row, std::size_t... Col>
+        static void SumRow(const Element* v, Element& out, std::index_sequence<Col...>)
+        {
+            std::array< T, M > sum{};
+            ([&] {
+                if constexpr (Rows[Row][Col] != 0)
+                    Xor(sum, v[Col].mSymbol);
+            }(), ...);
+            out.mSymbol = sum;
+            out.mStatus = SymbolStatus::Normal;
+        }
+
+        template <std::size_t E>
+        static void RepairAt(Element* v)
+        {
+            std::array< T, M > sum{};
+            [&]<std::size_t... Col>(std::index_sequence<Col...>) {
+                ([&] {
+                    if constexpr (Col != E && kCovers[E][Col] != 0)
+                        Xor(sum, v[Col].mSymbol);
+                }(), ...);
+            }(std::make_index_sequence<N>{});
+            v[E].mSymbol = sum;
+            v[E].mStatus = SymbolStatus::Normal;
+        }
+
+        static constexpr auto kRepair = []<std::size_t... E>(std::index_sequence<E...>) {
+            return std::array<void (*)(Element*), N>{&RepairAt<E>...};
+        }(std::make_index_sequence<N>{});
+    };
+
+    /**
+     * Профили: расширенный код Хэмминга (32, 26) по умолчанию и код Голея (23, 12).
+     */
+    template <typename T, int M>
+    using StaticExtendedHamming = StaticCode< T, M, ExtendedHammingMatrix<6>() >;
+
+    template <typename T, int M>
+    using StaticGolay = StaticCode< T, M, kGolayParityMatrix >;
+
+} // namespace hamming
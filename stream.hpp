@@ -0,0 +1,793 @@
+/**
+ * Потоковое кодирование/декодирование каскадным кодом: stdin/stdout или файлы.
+ */
+
+#pragma once
+
+#include <cstdio>             // std::FILE
+#include <cstdint>            // uint8_t
+#include <algorithm>          // std::clamp, std::fill
+#include <string>             // std::string
+#include <vector>             // std::vector
+#include <deque>              // std::deque
+#include <optional>           // std::optional
+#include <mutex>              // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <thread>             // std::thread
+#include <atomic>             // std::atomic
+#include <functional>         // std::function
+#include <iostream>           // std::cerr
+#include "rsexh.hpp"
+#include "interleave.hpp"
+
+namespace stream {
+
+    /**
+     * Ограниченная очередь между стадиями конвейера. Писатель блокируется,
+     * если очередь заполнена: так расход памяти не зависит от длины потока.
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(std::size_t capacity) : mCapacity{capacity} {}
+
+        /**
+         * Поставить элемент в очередь. Возвращает false, если очередь закрыта.
+         */
+        bool Push(T item)
+        {
+            std::unique_lock lock{mMutex};
+            mNotFull.wait(lock, [this] { return mClosed || mItems.size() < mCapacity; });
+            if (mClosed) {
+                return false;
+            }
+            mItems.push_back(std::move(item));
+            mNotEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * Извлечь элемент. Пустой результат - очередь закрыта и опустошена.
+         */
+        std::optional<T> Pop()
+        {
+            std::unique_lock lock{mMutex};
+            mNotEmpty.wait(lock, [this] { return mClosed || !mItems.empty(); });
+            if (mItems.empty()) {
+                return std::nullopt;
+            }
+            T item = std::move(mItems.front());
+            mItems.pop_front();
+            mNotFull.notify_one();
+            return item;
+        }
+
+        /**
+         * Закрыть очередь: новых элементов не будет.
+         */
+        void Close()
+        {
+            std::lock_guard lock{mMutex};
+            mClosed = true;
+            mNotEmpty.notify_all();
+            mNotFull.notify_all();
+        }
+
+    private:
+        std::size_t mCapacity;
+        std::deque<T> mItems;
+        std::mutex mMutex;
+        std::condition_variable mNotEmpty;
+        std::condition_variable mNotFull;
+        bool mClosed = false;
+    };
+
+    /**
+     * Пул потоков стадии кодирования/декодирования. Run(count, job) выполняет job(worker, i) для всех i < count
+     * (worker - номер потока, 0 - вызывающий) и возвращается, когда все задачи выполнены. Задачи
+     * раздаются атомарным счетчиком; потоки живут все время работы пула, а не создаются на каждую порцию.
+     */
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(int threads) : mThreads{std::max(threads, 1)}
+        {
+            for (int w = 1; w < mThreads; ++w)
+                mPool.emplace_back([this, w] { Loop(w); });
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard lock{mMutex};
+                mStop = true;
+            }
+            mStart.notify_all();
+            for (auto& thread : mPool)
+                thread.join();
+        }
+
+        int Size() const { return mThreads; }
+
+        void Run(int count, const std::function<void(int, int)>& job)
+        {
+            {
+                std::lock_guard lock{mMutex};
+                mJob = &job;
+                mCount = count;
+                mNext = 0;
+                mBusy = mThreads - 1;
+                mGeneration++;
+            }
+            mStart.notify_all();
+            Work(0);
+            std::unique_lock lock{mMutex};
+            mDone.wait(lock, [this] { return mBusy == 0; });
+        }
+
+    private:
+        void Work(int worker)
+        {
+            for (int i = mNext.fetch_add(1, std::memory_order_relaxed); i < mCount; i = mNext.fetch_add(1, std::memory_order_relaxed))
+                (*mJob)(worker, i);
+        }
+
+        void Loop(int worker)
+        {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock lock{mMutex};
+                    mStart.wait(lock, [&] { return mStop || mGeneration != seen; });
+                    if (mStop)
+                        return;
+                    seen = mGeneration;
+                }
+                Work(worker);
+                std::lock_guard lock{mMutex};
+                if (--mBusy == 0)
+                    mDone.notify_one();
+            }
+        }
+
+        int mThreads;
+        std::vector<std::thread> mPool;
+        std::mutex mMutex;
+        std::condition_variable mStart;
+        std::condition_variable mDone;
+        const std::function<void(int, int)>* mJob = nullptr;
+        int mCount = 0;
+        std::atomic<int> mNext{0};
+        int mBusy = 0;
+        uint64_t mGeneration = 0;
+        bool mStop = false;
+    };
+
+    /**
+     * Порция данных, передаваемая между стадиями конвейера.
+     */
+    using Batch = std::vector<uint8_t>;
+
+    /**
+     * Разметка кадра. Кадр - это один блок каскадного кода: N кодовых слов РС
+     * по 15 полубайт, упакованных по два полубайта в байт (старший первым).
+     * Первый информационный символ внешнего кода - заголовок: номер блока (4 байта)
+     * и длина полезной нагрузки (1 байт). Заголовок защищен кодом наравне с данными.
+     * Поток завершают концевые блоки (длина kEndMarker, см. EndBlocks): их нагрузка - длина потока в байтах
+     * (8 байт). По ней декодер обрезает нули, заменившие потерянный короткий последний блок,
+     * и обнаруживает обрезанный поток.
+     * При перемежении глубины D в поток пишутся суперкадры из D кадров (см. interleave::BlockInterleaver).
+     * Слова РС систематические, исправление - прямой индексацией (RsExhT::SwitchToDirect).
+     */
+    struct FrameLayout
+    {
+        static constexpr int kSymbolBytes = rsexh::RsExh::M2 / 2;
+        static_assert(rsexh::RsExh::M2 % 2 == 0, "Symbol must hold whole bytes");
+        static_assert(kSymbolBytes == 5, "Header is 4 bytes of sequence number and 1 byte of length");
+        static constexpr int kEndMarker = 255;
+        static constexpr int kEndBlocks = 2;
+        static constexpr int kEndPayloadBytes = 8;
+
+        explicit FrameLayout(const rsexh::RsExh& code)
+            : mK{code.mHammingCode.K}
+            , mN{code.mHammingCode.N}
+            , mPayloadBytes{(mK - 1) * kSymbolBytes}
+            , mFrameBytes{(mN * rsexh::RsExh::N + 1) / 2}
+        {
+            assert(mK > 1);
+            assert(mPayloadBytes < kEndMarker && mPayloadBytes >= kEndPayloadBytes);
+        }
+
+        int mK;
+        int mN;
+        int mPayloadBytes; // Полезная нагрузка одного блока, байт.
+        int mFrameBytes;   // Размер кадра в потоке, байт.
+    };
+
+    /**
+     * Статистика декодирования потока.
+     */
+    struct DecodeStats
+    {
+        long long mBlocks = 0;      // Принято кадров.
+        long long mErasedSum = 0;   // Сумма стертых символов внешнего кода.
+        long long mLost = 0;        // Блоков, замененных нулями (не декодированы или пропущены).
+        long long mDuplicates = 0;  // Отброшенных кадров с устаревшим номером.
+        long long mMiscorrections = 0; // Обнаруженных внешним кодом и стертых ложных исправлений РС.
+        long long mInconsistent = 0;   // Блоков, отвергнутых как несогласованные (входят в mLost).
+        long long mSkippedFrames = 0;  // Кадров, пропущенных при восстановлении границы суперкадра.
+        bool mIsTruncated = false;     // Концевой блок не принят: длина потока неизвестна (поток обрезан).
+    };
+
+    /**
+     * Параметры потокового кодирования/декодирования.
+     */
+    struct Options
+    {
+        int mDepth = 0;   // Глубина перемежения в блоках; 0 - без перемежения (кадры пишутся по словам РС).
+        int mThreads = 0; // Потоков стадии кодирования/декодирования; 0 - по числу аппаратных потоков.
+        bool mVerify = false; // Декодирование с обнаружением ложных исправлений РС (RsExhT::DecodeBlockVerified).
+    };
+
+    /**
+     * Количество блоков в одной порции конвейера на поток и емкость очередей (в порциях).
+     */
+    inline constexpr int kBatchBlocks = 64;
+    inline constexpr std::size_t kQueueCapacity = 4;
+
+    /**
+     * Количество блоков в порции, кратное глубине перемежения (порция - целое число суперкадров).
+     */
+    inline int BatchBlocks(int depth, int threads = 1)
+    {
+        const int blocks = kBatchBlocks * std::max(threads, 1);
+        return depth <= 1 ? blocks : (blocks + depth - 1) / depth * depth;
+    }
+
+    /**
+     * Количество концевых блоков после data_blocks блоков данных. Без перемежения - kEndBlocks кадров;
+     * с перемежением - остаток последнего суперкадра и еще целый суперкадр: суперкадр с одним поврежденным
+     * кадром не восстанавливается целиком, а так любой один поврежденный кадр оставляет концевой блок.
+     */
+    inline int EndBlocks(int depth, uint64_t data_blocks)
+    {
+        if (depth <= 1) {
+            return FrameLayout::kEndBlocks;
+        }
+        return depth - int(data_blocks % depth) + depth;
+    }
+
+    inline int Threads(const Options& options)
+    {
+        return options.mThreads > 0 ? options.mThreads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Открыть файл; "-" означает стандартный поток.
+     */
+    inline std::FILE* Open(const std::string& path, bool for_write)
+    {
+        if (path == "-") {
+            return for_write ? stdout : stdin;
+        }
+        return std::fopen(path.c_str(), for_write ? "wb" : "rb");
+    }
+
+    inline void Close(std::FILE* f)
+    {
+        if (!f) {
+            return;
+        }
+        if (f != stdin && f != stdout) {
+            std::fclose(f);
+        } else {
+            std::fflush(f);
+        }
+    }
+
+    /**
+     * Открыть вход и выход; выход не создается, если не открылся вход. При ошибке все открытое закрывается.
+     */
+    inline bool OpenPair(const std::string& input, const std::string& output, std::FILE*& in, std::FILE*& out)
+    {
+        in = Open(input, false);
+        out = in ? Open(output, true) : nullptr;
+        if (in && out) {
+            return true;
+        }
+        Close(in);
+        std::cerr << "Cannot open input or output\n";
+        return false;
+    }
+
+    /**
+     * Стадия чтения: читает порции заданного размера до конца потока.
+     */
+    inline void ReadStage(std::FILE* in, std::size_t batch_bytes, BoundedQueue<Batch>& out)
+    {
+        for (;;) {
+            Batch batch(batch_bytes);
+            std::size_t filled = 0;
+            while (filled < batch_bytes) {
+                const auto got = std::fread(batch.data() + filled, 1, batch_bytes - filled, in);
+                if (got == 0) {
+                    break;
+                }
+                filled += got;
+            }
+            batch.resize(filled);
+            if (filled == 0 || !out.Push(std::move(batch))) {
+                break;
+            }
+            if (filled < batch_bytes) {
+                break;
+            }
+        }
+        out.Close();
+    }
+
+    /**
+     * Стадия записи. Возвращает false при ошибке записи.
+     */
+    inline bool WriteStage(std::FILE* out, BoundedQueue<Batch>& in)
+    {
+        bool is_ok = true;
+        while (auto batch = in.Pop()) {
+            if (is_ok && std::fwrite(batch->data(), 1, batch->size(), out) != batch->size()) {
+                is_ok = false; // Продолжаем опустошать очередь, чтобы не блокировать кодер.
+            }
+        }
+        return is_ok;
+    }
+
+    /**
+     * Упаковать кодовые слова РС в кадр.
+     */
+    inline void PackFrame(const rsexh::Matrix<int>& v, uint8_t* frame, int frame_bytes)
+    {
+        std::fill(frame, frame + frame_bytes, 0);
+        for (int g = 0; const auto& word : v) {
+            for (const auto nibble : word) {
+                frame[g / 2] |= (g % 2 == 0) ? (nibble << 4) : nibble;
+                g++;
+            }
+        }
+    }
+
+    /**
+     * Распаковать кадр в кодовые слова РС. Недостающие (обрезанные) слова остаются пустыми - стертыми.
+     */
+    inline void UnpackFrame(const uint8_t* frame, int available_bytes, int words, rsexh::Matrix<int>& v)
+    {
+        constexpr int n = rsexh::RsExh::N;
+        v.resize(words);
+        for (int i = 0; i < words; ++i) {
+            if ((i + 1) * n > available_bytes * 2) {
+                v[i].clear();
+                continue;
+            }
+            v[i].resize(n);
+            for (int t = 0; t < n; ++t) {
+                const int g = i * n + t;
+                v[i][t] = (g % 2 == 0) ? (frame[g / 2] >> 4) : (frame[g / 2] & 15);
+            }
+        }
+    }
+
+    /**
+     * Информационные символы блока: заголовок (номер и длина) и length байт полезной нагрузки, дополненной нулями.
+     * @param is_end Концевой блок: в заголовке вместо длины - FrameLayout::kEndMarker.
+     */
+    inline void FillBlock(const FrameLayout& layout, uint32_t seq, const uint8_t* payload, int length,
+                          hamming::CodeWord<int, rsexh::RsExh::M2>& a, bool is_end = false)
+    {
+        a.resize(layout.mK);
+        uint8_t bytes[FrameLayout::kSymbolBytes];
+        for (int k = 0; k < layout.mK; ++k) {
+            for (int j = 0; j < FrameLayout::kSymbolBytes; ++j) {
+                if (k == 0) {
+                    bytes[j] = j < 4 ? uint8_t(seq >> (8 * j)) : uint8_t(is_end ? FrameLayout::kEndMarker : length);
+                } else {
+                    const int pos = (k - 1) * FrameLayout::kSymbolBytes + j;
+                    bytes[j] = pos < length ? payload[pos] : 0;
+                }
+            }
+            a[k].mStatus = hamming::SymbolStatus::Normal;
+            for (int j = 0; j < rsexh::RsExh::M2; ++j) {
+                a[k].mSymbol[j] = (j % 2 == 0) ? (bytes[j / 2] >> 4) : (bytes[j / 2] & 15);
+            }
+        }
+    }
+
+    /**
+     * Концевой блок: длина потока в байтах.
+     */
+    inline void FillEndBlock(const FrameLayout& layout, uint32_t seq, uint64_t stream_bytes,
+                             hamming::CodeWord<int, rsexh::RsExh::M2>& a)
+    {
+        uint8_t payload[FrameLayout::kEndPayloadBytes];
+        for (int j = 0; j < FrameLayout::kEndPayloadBytes; ++j)
+            payload[j] = uint8_t(stream_bytes >> (8 * j));
+        FillBlock(layout, seq, payload, FrameLayout::kEndPayloadBytes, a, true);
+    }
+
+    /**
+     * Блок, декодированный стадией декодирования: заголовок и полезная нагрузка.
+     */
+    struct DecodedBlock
+    {
+        bool mIsOk = false;
+        int mErased = 0;
+        int mMiscorrections = 0;
+        bool mIsInconsistent = false;
+        uint32_t mSeq = 0;
+        int mLength = 0;
+        std::vector<uint8_t> mPayload;
+        bool mIsEnd = false;       // Концевой блок.
+        uint64_t mStreamBytes = 0; // Длина потока (только у концевого блока).
+    };
+
+    /**
+     * Разобрать информационные символы декодированного блока.
+     */
+    inline void ReadBlock(const FrameLayout& layout, const hamming::CodeWord<int, rsexh::RsExh::M2>& a, DecodedBlock& block)
+    {
+        uint8_t bytes[FrameLayout::kSymbolBytes];
+        auto symbol_bytes = [&](int k) {
+            for (int j = 0; j < FrameLayout::kSymbolBytes; ++j) {
+                bytes[j] = (a[k].mSymbol[2 * j] << 4) | a[k].mSymbol[2 * j + 1];
+            }
+        };
+        symbol_bytes(0);
+        block.mSeq = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (uint32_t(bytes[3]) << 24);
+        block.mIsEnd = bytes[4] == FrameLayout::kEndMarker;
+        block.mLength = block.mIsEnd ? FrameLayout::kEndPayloadBytes : std::min<int>(bytes[4], layout.mPayloadBytes);
+        block.mPayload.clear();
+        for (int k = 1; k < layout.mK; ++k) {
+            symbol_bytes(k);
+            const int pos = (k - 1) * FrameLayout::kSymbolBytes;
+            const int count = std::clamp(block.mLength - pos, 0, FrameLayout::kSymbolBytes);
+            block.mPayload.insert(block.mPayload.end(), bytes, bytes + count);
+        }
+        block.mStreamBytes = 0;
+        if (block.mIsEnd) {
+            for (int j = 0; j < FrameLayout::kEndPayloadBytes; ++j)
+                block.mStreamBytes |= uint64_t(block.mPayload[j]) << (8 * j);
+            block.mPayload.clear();
+        }
+    }
+
+    /**
+     * Рабочее состояние потока стадии кодирования/декодирования: своя копия кода (декодер хранит
+     * промежуточное состояние) и буферы; таблица поправок разделяется копиями только на чтение.
+     */
+    struct Worker
+    {
+        rsexh::RsExh mCode;
+        std::vector<rsexh::Matrix<int>> mGroup;
+        hamming::CodeWord<int, rsexh::RsExh::M2> mBlock;
+    };
+
+    inline std::vector<Worker> MakeWorkers(const rsexh::RsExh& code, int threads, int depth)
+    {
+        return std::vector<Worker>(threads, Worker{code, std::vector<rsexh::Matrix<int>>(std::max(depth, 1)), {}});
+    }
+
+    /**
+     * Закодировать поток: чтение -> кодирование -> запись, три перекрывающиеся стадии.
+     * Блоки порции кодируются параллельно пулом потоков (по кадру или суперкадру на задачу).
+     * Порции читаются с опережением на одну: к последней добавляются концевые блоки.
+     */
+    inline int EncodeStream(const std::string& input, const std::string& output, const Options& options = {})
+    {
+        const int depth = options.mDepth;
+        rsexh::RsExh code;
+        code.SwitchToDirect(true);
+        const FrameLayout layout{code};
+        std::FILE* in;
+        std::FILE* out;
+        if (!OpenPair(input, output, in, out)) {
+            return 1;
+        }
+        WorkerPool pool{Threads(options)};
+        auto workers = MakeWorkers(code, pool.Size(), depth);
+        BoundedQueue<Batch> read_queue{kQueueCapacity};
+        BoundedQueue<Batch> write_queue{kQueueCapacity};
+        std::thread reader{ReadStage, in, std::size_t(layout.mPayloadBytes) * BatchBlocks(depth, pool.Size()), std::ref(read_queue)};
+        bool write_ok = true;
+        std::thread writer{[&] { write_ok = WriteStage(out, write_queue); }};
+
+        const interleave::BlockInterleaver interleaver{std::max(depth, 1), layout.mN};
+        const int unit = interleaver.Depth(); // Блоков в задаче: кадр или суперкадр.
+        uint64_t seq = 0; // Блоков записано; номер блока в заголовке - младшие 32 бита.
+        uint64_t stream_bytes = 0;
+        std::optional<Batch> batch = read_queue.Pop();
+        for (;;) {
+            std::optional<Batch> next = batch ? read_queue.Pop() : std::nullopt;
+            const bool is_last = !next;
+            const Batch input_bytes = batch ? std::move(*batch) : Batch{};
+            stream_bytes += input_bytes.size();
+            const int data_blocks = (input_bytes.size() + layout.mPayloadBytes - 1) / layout.mPayloadBytes;
+            const int blocks = data_blocks + (is_last ? EndBlocks(depth, seq + data_blocks) : 0);
+            Batch frames(std::size_t(blocks) * layout.mFrameBytes);
+            pool.Run((blocks + unit - 1) / unit, [&](int w, int u) {
+                auto& worker = workers[w];
+                const int first = u * unit;
+                const int count = std::min(unit, blocks - first);
+                for (int s = 0; s < count; ++s) {
+                    const int b = first + s;
+                    if (b < data_blocks) {
+                        const std::size_t offset = std::size_t(b) * layout.mPayloadBytes;
+                        const int length = std::min<std::size_t>(layout.mPayloadBytes, input_bytes.size() - offset);
+                        FillBlock(layout, uint32_t(seq + b), input_bytes.data() + offset, length, worker.mBlock);
+                    } else {
+                        FillEndBlock(layout, uint32_t(seq + b), stream_bytes, worker.mBlock);
+                    }
+                    worker.mCode.EncodeBlock(worker.mBlock, worker.mGroup[s]);
+                    if (depth == 0) {
+                        PackFrame(worker.mGroup[s], frames.data() + std::size_t(b) * layout.mFrameBytes, layout.mFrameBytes);
+                    }
+                }
+                if (depth > 0) {
+                    // Суперкадр собран: полубайты пишутся сразу в кадры потока, без промежуточной копии.
+                    uint8_t* super = frames.data() + std::size_t(first) * layout.mFrameBytes;
+                    interleaver.Interleave(worker.mGroup.data(), count, [super](std::size_t g, int nibble) {
+                        super[g / 2] |= (g % 2 == 0) ? (nibble << 4) : nibble;
+                    });
+                }
+            });
+            seq += blocks;
+            write_queue.Push(std::move(frames));
+            if (is_last) {
+                break;
+            }
+            batch = std::move(next);
+        }
+        write_queue.Close();
+        reader.join();
+        writer.join();
+        Close(in);
+        Close(out);
+        if (!write_ok) {
+            std::cerr << "Write error\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * Декодировать кадр (depth = 0) или суперкадр из bytes байт потока в blocks.
+     * @return Количество блоков.
+     */
+    inline int DecodeUnit(Worker& worker, const FrameLayout& layout, const interleave::BlockInterleaver& interleaver,
+                          const Options& options, const uint8_t* data, std::size_t bytes, DecodedBlock* blocks)
+    {
+        const int depth = options.mDepth;
+        const int count = (bytes + layout.mFrameBytes - 1) / layout.mFrameBytes;
+        if (depth == 0) {
+            UnpackFrame(data, bytes, layout.mN, worker.mGroup[0]);
+        } else {
+            interleaver.Deinterleave([data](std::size_t g) {
+                return (g % 2 == 0) ? (data[g / 2] >> 4) : (data[g / 2] & 15);
+            }, bytes * 2, worker.mGroup.data(), count);
+        }
+        for (int s = 0; s < count; ++s) {
+            auto& block = blocks[s];
+            auto& code = worker.mCode;
+            if (options.mVerify) {
+                block.mIsOk = code.DecodeBlockVerified(worker.mGroup[s], worker.mBlock, block.mErased);
+                block.mMiscorrections = code.mLastMiscorrections;
+                block.mIsInconsistent = code.mLastInconsistent;
+            } else {
+                block.mIsOk = code.DecodeBlock(worker.mGroup[s], worker.mBlock, block.mErased);
+            }
+            if (block.mIsOk) {
+                ReadBlock(layout, worker.mBlock, block);
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Суперкадр декодирован на правильной границе: хотя бы один блок восстановлен, и номера восстановленных
+     * блоков идут подряд (номер блока минус его место в суперкадре у всех один). Суперкадр, собранный
+     * со сдвигом на кадр, перемешивает полубайты двух суперкадров и не восстанавливается целиком.
+     */
+    inline bool IsAligned(const DecodedBlock* blocks, int count)
+    {
+        bool has_first = false;
+        uint32_t first = 0;
+        for (int s = 0; s < count; ++s) {
+            if (!blocks[s].mIsOk)
+                continue;
+            if (has_first && blocks[s].mSeq - uint32_t(s) != first)
+                return false;
+            first = blocks[s].mSeq - uint32_t(s);
+            has_first = true;
+        }
+        return has_first;
+    }
+
+    /**
+     * Декодировать поток. Неисправимые и пропущенные блоки заменяются нулями полной длины,
+     * чтобы сохранить смещения данных; в этом случае код возврата 2.
+     * Кадры (суперкадры) порции декодируются параллельно, данные собираются по порядку.
+     * При перемежении граница суперкадра берется не из смещения в потоке, а из номеров блоков: если суперкадр
+     * не восстанавливается и следующий за ним тоже (поврежденный на месте суперкадр границу не сдвигает),
+     * пробуются сдвиги на 1..D-1 кадров, и при согласованных номерах кадры до сдвига
+     * (остаток поврежденного суперкадра) пропускаются; пропуск в нумерации затем заполняется нулями.
+     * Так выпавший или лишний целый кадр стоит одного суперкадра, а не всего остатка потока.
+     * Нули потерянных блоков откладываются до следующих данных: после концевого блока они обрезаются
+     * по длине потока (короткий последний блок не удлиняет выход). Без концевого блока поток считается
+     * обрезанным (DecodeStats::mIsTruncated, код возврата 2), отложенные нули пишутся полностью.
+     * @param options Глубина перемежения должна совпадать с той, с которой поток был закодирован.
+     * @param result Статистика декодирования (необязательно).
+     */
+    inline int DecodeStream(const std::string& input, const std::string& output, const Options& options = {},
+                            DecodeStats* result = nullptr)
+    {
+        const int depth = options.mDepth;
+        rsexh::RsExh code;
+        code.SwitchToDirect(true);
+        const FrameLayout layout{code};
+        std::FILE* in;
+        std::FILE* out;
+        if (!OpenPair(input, output, in, out)) {
+            return 1;
+        }
+        // Разрыв нумерации больше этого порога считаем поврежденным заголовком, а не потерей блоков.
+        constexpr uint32_t kMaxGap = 1u << 16;
+        WorkerPool pool{Threads(options)};
+        auto workers = MakeWorkers(code, pool.Size(), depth);
+        const std::size_t batch_bytes = std::size_t(layout.mFrameBytes) * BatchBlocks(depth, pool.Size());
+        BoundedQueue<Batch> read_queue{kQueueCapacity};
+        BoundedQueue<Batch> write_queue{kQueueCapacity};
+        std::thread reader{ReadStage, in, batch_bytes, std::ref(read_queue)};
+        bool write_ok = true;
+        std::thread writer{[&] { write_ok = WriteStage(out, write_queue); }};
+
+        DecodeStats stats;
+        const interleave::BlockInterleaver interleaver{std::max(depth, 1), layout.mN};
+        const int unit = interleaver.Depth(); // Блоков (кадров) в суперкадре.
+        const std::size_t unit_bytes = std::size_t(layout.mFrameBytes) * unit;
+        const bool can_resync = depth > 1;
+        std::vector<DecodedBlock> decoded;
+        std::vector<DecodedBlock> trial(unit);
+        // Принятые, но еще не декодированные байты; начинаются на границе суперкадра.
+        // Один суперкадр сверх декодируемых всегда остается в запасе для поиска сдвига.
+        Batch pending;
+        bool is_end = false;
+        uint32_t expected = 0;
+        uint64_t written = 0;      // Байт выхода, включая записанные нули.
+        std::size_t deferred = 0;  // Нули потерянных блоков, еще не записанные.
+        bool has_end = false;
+        uint64_t stream_bytes = 0;
+        for (;;) {
+            if (!is_end && pending.size() < batch_bytes + unit_bytes) {
+                if (auto batch = read_queue.Pop()) {
+                    pending.insert(pending.end(), batch->begin(), batch->end());
+                } else {
+                    is_end = true;
+                }
+                continue;
+            }
+            if (pending.empty()) {
+                break;
+            }
+            const std::size_t units = is_end ? (pending.size() + unit_bytes - 1) / unit_bytes : pending.size() / unit_bytes - 1;
+            decoded.resize(units * unit);
+            std::vector<int> counts(units);
+            pool.Run(units, [&](int w, int u) {
+                const std::size_t offset = u * unit_bytes;
+                counts[u] = DecodeUnit(workers[w], layout, interleaver, options, pending.data() + offset,
+                                       std::min(unit_bytes, pending.size() - offset), &decoded[u * unit]);
+            });
+            Batch data;
+            data.reserve(units * unit * layout.mPayloadBytes);
+            std::size_t consumed = 0;
+            // Следующий суперкадр на прежней границе выровнен: текущий просто поврежден, кадры не выпадали.
+            auto is_next_aligned = [&](std::size_t u) {
+                if (u + 1 < units) {
+                    return IsAligned(&decoded[(u + 1) * unit], counts[u + 1]);
+                }
+                const std::size_t offset = consumed + unit_bytes;
+                if (offset >= pending.size()) {
+                    return false;
+                }
+                const int count = DecodeUnit(workers[0], layout, interleaver, options, pending.data() + offset,
+                                             std::min(unit_bytes, pending.size() - offset), trial.data());
+                return IsAligned(trial.data(), count);
+            };
+            for (std::size_t u = 0; u < units; ++u) {
+                const DecodedBlock* blocks = &decoded[u * unit];
+                if (can_resync && !IsAligned(blocks, counts[u]) && !is_next_aligned(u)) {
+                    int shift = 0;
+                    for (int k = 1; k < unit && consumed + k * layout.mFrameBytes < pending.size(); ++k) {
+                        const std::size_t offset = consumed + std::size_t(k) * layout.mFrameBytes;
+                        const int count = DecodeUnit(workers[0], layout, interleaver, options, pending.data() + offset,
+                                                     std::min(unit_bytes, pending.size() - offset), trial.data());
+                        if (IsAligned(trial.data(), count)) {
+                            shift = k;
+                            break;
+                        }
+                    }
+                    if (shift > 0) {
+                        // Остаток поврежденного суперкадра пропускается; суперкадры за ним декодируются заново.
+                        stats.mSkippedFrames += shift;
+                        consumed += std::size_t(shift) * layout.mFrameBytes;
+                        break;
+                    }
+                }
+                for (int s = 0; s < counts[u] && !has_end; ++s) {
+                    const auto& block = blocks[s];
+                    stats.mBlocks++;
+                    stats.mErasedSum += block.mErased;
+                    stats.mMiscorrections += block.mMiscorrections;
+                    stats.mInconsistent += block.mIsInconsistent;
+                    if (!block.mIsOk) {
+                        stats.mLost++;
+                        deferred += layout.mPayloadBytes;
+                        expected++;
+                        continue;
+                    }
+                    const int32_t gap = int32_t(block.mSeq - expected);
+                    if (gap < 0) {
+                        stats.mDuplicates++;
+                        continue;
+                    }
+                    if (gap > 0 && uint32_t(gap) < kMaxGap) {
+                        stats.mLost += gap;
+                        deferred += std::size_t(gap) * layout.mPayloadBytes;
+                        expected = block.mSeq;
+                    }
+                    expected++;
+                    if (block.mIsEnd) {
+                        has_end = true;
+                        stream_bytes = block.mStreamBytes;
+                        continue;
+                    }
+                    data.insert(data.end(), deferred, 0);
+                    data.insert(data.end(), block.mPayload.begin(), block.mPayload.end());
+                    written += deferred + block.mPayload.size();
+                    deferred = 0;
+                }
+                consumed = std::min(consumed + unit_bytes, pending.size());
+            }
+            pending.erase(pending.begin(), pending.begin() + consumed);
+            write_queue.Push(std::move(data));
+        }
+        // Хвост: нули потерянных последних блоков - до длины потока, если она известна.
+        std::size_t tail = deferred;
+        if (has_end && stream_bytes >= written) {
+            const uint64_t missing = stream_bytes - written;
+            if (missing <= deferred) {
+                // Блоки, чьи нули обрезаны целиком, - потерянные копии концевого блока, а не данные.
+                stats.mLost -= (deferred - missing) / layout.mPayloadBytes;
+            } else {
+                stats.mLost += (missing - deferred + layout.mPayloadBytes - 1) / layout.mPayloadBytes;
+            }
+            tail = missing;
+        }
+        stats.mIsTruncated = !has_end;
+        write_queue.Push(Batch(tail, 0));
+        write_queue.Close();
+        reader.join();
+        writer.join();
+        Close(in);
+        Close(out);
+        std::cerr << "Blocks: " << stats.mBlocks << ", erased symbols: " << stats.mErasedSum
+                  << ", lost blocks: " << stats.mLost << ", duplicates: " << stats.mDuplicates
+                  << ", miscorrections: " << stats.mMiscorrections << ", inconsistent blocks: " << stats.mInconsistent
+                  << ", skipped frames: " << stats.mSkippedFrames << (stats.mIsTruncated ? ", stream is truncated" : "") << std::endl;
+        if (result) {
+            *result = stats;
+        }
+        if (!write_ok) {
+            std::cerr << "Write error\n";
+            return 1;
+        }
+        return stats.mLost == 0 && !stats.mIsTruncated ? 0 : 2;
+    }
+
+} // namespace stream
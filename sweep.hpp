@@ -0,0 +1,237 @@
+/**
+ * Построение кривых BER/FER: перебор профилей кода (число проверочных символов РС, внешний код,
+ * глубина исправления) и вероятностей ошибки канала. Каждая точка моделируется порциями блоков
+ * на всех потоках (sim::Run) и останавливается, как только набрано заданное число ошибочных блоков
+ * или доверительный интервал FER стал достаточно узким. Результаты - CSV или JSON.
+ */
+
+#pragma once
+
+#include <cstdint>   // uint64_t
+#include <cstdlib>   // std::atoi
+#include <thread>    // std::thread::hardware_concurrency
+#include <chrono>    // std::chrono::steady_clock
+#include <string>    // std::string
+#include <vector>    // std::vector
+#include <sstream>   // std::istringstream
+#include <ostream>   // std::ostream
+#include <algorithm> // std::max, std::min
+#include "rsexh.hpp"
+#include "static_hamming.hpp"
+#include "sim.hpp"
+
+namespace sweep {
+
+    /**
+     * Профиль кода. Текстовая запись: "r<R>-<outer>-c<mode>", например "r5-hamming-c2" -
+     * РС (15, 10), расширенный код Хэмминга (32, 26), исправление 1- и 2-ошибок;
+     * "r6-golay-c1" - РС (15, 9), код Голея (23, 12), исправление только 1-ошибок.
+     */
+    struct Profile
+    {
+        std::string mName;
+        int mInnerR = 5;                // Проверочных символов РС: 5 или 6.
+        std::string mOuter = "hamming"; // Внешний код: hamming или golay.
+        rsexh::CorrectionMode mMode = rsexh::CorrectionMode::Correct2;
+    };
+
+    /**
+     * Разобрать запись профиля. Возвращает false, если профиль не поддерживается.
+     */
+    inline bool ParseProfile(const std::string& spec, Profile& profile)
+    {
+        const auto first = spec.find('-');
+        const auto last = spec.rfind('-');
+        if (first == std::string::npos || first == last || spec[0] != 'r' || spec[last + 1] != 'c')
+            return false;
+        profile.mName = spec;
+        profile.mInnerR = std::atoi(spec.substr(1, first - 1).c_str());
+        profile.mOuter = spec.substr(first + 1, last - first - 1);
+        const int mode = std::atoi(spec.substr(last + 2).c_str());
+        if (mode < 0 || mode > 2)
+            return false;
+        profile.mMode = static_cast<rsexh::CorrectionMode>(mode);
+        return (profile.mInnerR == 5 || profile.mInnerR == 6) && (profile.mOuter == "hamming" || profile.mOuter == "golay");
+    }
+
+    /**
+     * Вызвать f(code) с кодом профиля (тип кода выбирается при компиляции, профиль - при работе).
+     */
+    template <typename F>
+    inline bool WithCode(const Profile& profile, F&& f)
+    {
+        auto run = [&](auto& code) {
+            code.mHammingCode.SwitchToSystematic(false);
+            code.mMode = profile.mMode;
+            f(code);
+            return true;
+        };
+        if (profile.mOuter == "hamming" && profile.mInnerR == 5) {
+            static rsexh::RsExhT<5, 6> code;
+            return run(code);
+        }
+        if (profile.mOuter == "hamming" && profile.mInnerR == 6) {
+            static rsexh::RsExhT<6, 6> code;
+            return run(code);
+        }
+        if (profile.mOuter == "golay" && profile.mInnerR == 5) {
+            static rsexh::RsExhT<5, 11> code{hamming::ToMatrix(hamming::kGolayParityMatrix), 7};
+            return run(code);
+        }
+        if (profile.mOuter == "golay" && profile.mInnerR == 6) {
+            static rsexh::RsExhT<6, 11> code{hamming::ToMatrix(hamming::kGolayParityMatrix), 7};
+            return run(code);
+        }
+        return false;
+    }
+
+    /**
+     * Правило остановки точки.
+     */
+    struct StopRule
+    {
+        long long mTargetBlockErrors = 100; // Остановиться, набрав столько ошибочных блоков.
+        double mTargetRelWidth = 0.2;       // ... или когда полуширина интервала FER меньше этой доли FER.
+        long long mMinBlocks = 1000;        // Не раньше, чем после стольких блоков.
+        long long mMaxBlocks = 10000000;    // Предел блоков на точку.
+        long long mRoundBlocks = 1024;      // Блоков за порцию: правило остановки проверяется на их границах.
+        double mZ = 1.96;
+        uint64_t mSeed = 1;
+        int mThreads = 0;
+    };
+
+    struct Point
+    {
+        Profile mProfile;
+        double mChannelBer = 0.;
+        sim::Result mResult;
+        double mFer = 0.;
+        double mFerLow = 0.;     // Доверительный интервал FER (Уилсон).
+        double mFerHigh = 0.;
+        std::string mStop;       // Причина остановки: errors, width или limit.
+        double mSeconds = 0.;
+    };
+
+    using sim::WilsonInterval; // Определен в sim.hpp: нужен и выборке по значимости.
+
+    /**
+     * Смоделировать одну точку кривой с ранней остановкой. Порции фиксированного размера продолжают нумерацию
+     * блоков, поэтому при заданном зерне результат не зависит от числа потоков.
+     */
+    template <typename Code>
+    Point RunPoint(const Code& code, const Profile& profile, double ber, const StopRule& rule)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const int threads = rule.mThreads > 0 ? rule.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        sim::Config config;
+        config.mBer = ber;
+        config.mSeed = rule.mSeed;
+        config.mThreads = threads;
+        config.mBlocks = rule.mRoundBlocks;
+        Point point;
+        point.mProfile = profile;
+        point.mChannelBer = ber;
+        auto& total = point.mResult;
+        for (;;) {
+            config.mBlocks = std::min(config.mBlocks, rule.mMaxBlocks - total.mBlocks);
+            const auto round = sim::Run(code, config);
+            config.mFirstBlock += config.mBlocks;
+            total.mBlocks += round.mBlocks;
+            total.mBits += round.mBits;
+            total.mBitErrors += round.mBitErrors;
+            total.mBlockErrors += round.mBlockErrors;
+            WilsonInterval(total.mBlockErrors, total.mBlocks, rule.mZ, point.mFerLow, point.mFerHigh);
+            point.mFer = (1. * total.mBlockErrors) / total.mBlocks;
+            if (total.mBlockErrors >= rule.mTargetBlockErrors) {
+                point.mStop = "errors";
+                break;
+            }
+            if (total.mBlockErrors > 0 && total.mBlocks >= rule.mMinBlocks &&
+                (point.mFerHigh - point.mFerLow) / 2. <= rule.mTargetRelWidth * point.mFer) {
+                point.mStop = "width";
+                break;
+            }
+            if (total.mBlocks >= rule.mMaxBlocks) {
+                point.mStop = "limit";
+                break;
+            }
+        }
+        point.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return point;
+    }
+
+    /**
+     * Все сочетания профилей и вероятностей ошибки канала. Неподдерживаемые профили пропускаются.
+     * @param on_point Вызывается после каждой точки (например, для печати хода работы).
+     */
+    template <typename OnPoint>
+    std::vector<Point> Run(const std::vector<Profile>& profiles, const std::vector<double>& bers, const StopRule& rule,
+                           OnPoint&& on_point)
+    {
+        std::vector<Point> points;
+        for (const auto& profile : profiles) {
+            WithCode(profile, [&](const auto& code) {
+                for (const double ber : bers) {
+                    points.push_back(RunPoint(code, profile, ber, rule));
+                    on_point(points.back());
+                }
+            });
+        }
+        return points;
+    }
+
+    inline const char* ModeName(rsexh::CorrectionMode mode)
+    {
+        switch (mode) {
+        case rsexh::CorrectionMode::ErasureOnly:
+            return "erasure";
+        case rsexh::CorrectionMode::Correct1:
+            return "correct1";
+        case rsexh::CorrectionMode::Correct2:
+            return "correct2";
+        }
+        return "";
+    }
+
+    inline void WriteCsv(std::ostream& out, const std::vector<Point>& points)
+    {
+        out << "profile,inner_r,outer,mode,channel_ber,blocks,bit_errors,block_errors,ber,fer,fer_low,fer_high,stop,seconds\n";
+        for (const auto& p : points) {
+            out << p.mProfile.mName << ',' << p.mProfile.mInnerR << ',' << p.mProfile.mOuter << ','
+                << ModeName(p.mProfile.mMode) << ',' << p.mChannelBer << ',' << p.mResult.mBlocks << ','
+                << p.mResult.mBitErrors << ',' << p.mResult.mBlockErrors << ',' << p.mResult.Ber() << ','
+                << p.mFer << ',' << p.mFerLow << ',' << p.mFerHigh << ',' << p.mStop << ',' << p.mSeconds << '\n';
+        }
+    }
+
+    inline void WriteJson(std::ostream& out, const std::vector<Point>& points)
+    {
+        out << "[\n";
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            const auto& p = points[i];
+            out << "  {\"profile\": \"" << p.mProfile.mName << "\", \"inner_r\": " << p.mProfile.mInnerR
+                << ", \"outer\": \"" << p.mProfile.mOuter << "\", \"mode\": \"" << ModeName(p.mProfile.mMode)
+                << "\", \"channel_ber\": " << p.mChannelBer << ", \"blocks\": " << p.mResult.mBlocks
+                << ", \"bit_errors\": " << p.mResult.mBitErrors << ", \"block_errors\": " << p.mResult.mBlockErrors
+                << ", \"ber\": " << p.mResult.Ber() << ", \"fer\": " << p.mFer << ", \"fer_low\": " << p.mFerLow
+                << ", \"fer_high\": " << p.mFerHigh << ", \"stop\": \"" << p.mStop << "\", \"seconds\": " << p.mSeconds
+                << (i + 1 < points.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    }
+
+    /**
+     * Разобрать список через запятую.
+     */
+    inline std::vector<std::string> SplitList(const std::string& list)
+    {
+        std::vector<std::string> items;
+        std::istringstream in{list};
+        for (std::string item; std::getline(in, item, ',');) {
+            if (!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+} // namespace sweep
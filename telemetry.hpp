@@ -0,0 +1,272 @@
+/**
+ * Телеметрия декодера: счетчики исходов внутреннего и внешнего кодов и гистограммы.
+ * У каждого потока свой блок счетчиков: поток-владелец пишет в него без блокировок и без
+ * атомарных read-modify-write (единственный писатель: load + store с relaxed), снимок суммирует
+ * блоки всех потоков. Блок завершившегося потока добавляется к итогам и освобождается.
+ * Вся запись идет через макросы RSEXH_COUNT/RSEXH_RECORD/RSEXH_TIME: при RSEXH_TELEMETRY=0
+ * они пустые, и инструментирование горячих путей исчезает при компиляции; снимки тогда нулевые.
+ */
+
+#pragma once
+
+#include <array>     // std::array
+#include <atomic>    // std::atomic
+#include <bit>       // std::bit_width
+#include <chrono>    // std::chrono::steady_clock
+#include <cstdint>   // uint64_t
+#include <memory>    // std::unique_ptr
+#include <mutex>     // std::mutex
+#include <ostream>   // std::ostream
+#include <vector>    // std::vector
+#include <algorithm> // std::find_if, std::min
+
+#ifndef RSEXH_TELEMETRY
+#define RSEXH_TELEMETRY 1
+#endif
+
+namespace telemetry {
+
+    enum class Counter
+    {
+        InnerWords,          // Слов РС подано на исправление.
+        InnerClean,          // Нулевой синдром.
+        InnerCorrected1,     // Исправлена 1-ошибка.
+        InnerCorrected2,     // Исправлена 2-ошибка.
+        InnerFailed,         // Ошибка обнаружена, но не исправлена (слово стерто).
+        ShiftIterations,     // Итерации цикла сдвигов синдрома при поиске 2-ошибки.
+        OuterBlocks,         // Блоков внешнего кода декодировано.
+        OuterErasures,       // Сумма стертых символов внешнего кода.
+        OuterFailures,       // Блок не восстановлен (слишком много стираний или вырожденная подматрица).
+        OuterMiscorrections, // Обнаруженные внешним кодом ложные исправления РС (DecodeBlockVerified).
+        kCount
+    };
+
+    enum class Histogram
+    {
+        OuterErasures,  // Корзина - число стираний в блоке (63 - 63 и больше).
+        DecodeLatency,  // Корзина b - время декодирования блока в [2^(b-1), 2^b) нс.
+        kCount
+    };
+
+    inline constexpr int kCounters = int(Counter::kCount);
+    inline constexpr int kHistograms = int(Histogram::kCount);
+    inline constexpr int kBuckets = 64;
+
+    /**
+     * Снимок всех счетчиков. Разность двух снимков - телеметрия за интервал.
+     */
+    struct Snapshot
+    {
+        std::array<uint64_t, kCounters> mCounters{};
+        std::array<std::array<uint64_t, kBuckets>, kHistograms> mHistograms{};
+
+        uint64_t operator[](Counter counter) const { return mCounters[int(counter)]; }
+
+        /**
+         * Доля numerator / denominator (0, если знаменатель нулевой).
+         */
+        double Rate(Counter numerator, Counter denominator) const
+        {
+            const uint64_t d = (*this)[denominator];
+            return d > 0 ? double((*this)[numerator]) / d : 0.;
+        }
+
+        /**
+         * Корзина, в которой набирается доля q записей гистограммы; -1 - записей нет.
+         */
+        int Percentile(Histogram histogram, double q) const
+        {
+            const auto& buckets = mHistograms[int(histogram)];
+            uint64_t total = 0;
+            for (const auto count : buckets)
+                total += count;
+            if (total == 0)
+                return -1;
+            uint64_t sum = 0;
+            for (int b = 0; b < kBuckets; ++b) {
+                sum += buckets[b];
+                if (sum >= q * total)
+                    return b;
+            }
+            return kBuckets - 1;
+        }
+
+        Snapshot& operator+=(const Snapshot& other)
+        {
+            for (int i = 0; i < kCounters; ++i)
+                mCounters[i] += other.mCounters[i];
+            for (int h = 0; h < kHistograms; ++h) {
+                for (int b = 0; b < kBuckets; ++b)
+                    mHistograms[h][b] += other.mHistograms[h][b];
+            }
+            return *this;
+        }
+
+        Snapshot operator-(const Snapshot& earlier) const
+        {
+            Snapshot result = *this;
+            for (int i = 0; i < kCounters; ++i)
+                result.mCounters[i] -= earlier.mCounters[i];
+            for (int h = 0; h < kHistograms; ++h) {
+                for (int b = 0; b < kBuckets; ++b)
+                    result.mHistograms[h][b] -= earlier.mHistograms[h][b];
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Блок счетчиков одного потока.
+     */
+    struct Slot
+    {
+        std::array<std::atomic<uint64_t>, kCounters> mCounters{};
+        std::array<std::array<std::atomic<uint64_t>, kBuckets>, kHistograms> mHistograms{};
+
+        void Load(Snapshot& snapshot) const
+        {
+            for (int i = 0; i < kCounters; ++i)
+                snapshot.mCounters[i] += mCounters[i].load(std::memory_order_relaxed);
+            for (int h = 0; h < kHistograms; ++h) {
+                for (int b = 0; b < kBuckets; ++b)
+                    snapshot.mHistograms[h][b] += mHistograms[h][b].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * Реестр блоков потоков. Мьютекс берется только при появлении и завершении потока и при снимке.
+     */
+    class Registry
+    {
+    public:
+        static Registry& Instance()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        Slot* Attach()
+        {
+            std::lock_guard lock{mMutex};
+            return mSlots.emplace_back(std::make_unique<Slot>()).get();
+        }
+
+        void Detach(Slot* slot)
+        {
+            std::lock_guard lock{mMutex};
+            slot->Load(mRetired);
+            const auto it = std::find_if(mSlots.begin(), mSlots.end(), [slot](const auto& p) { return p.get() == slot; });
+            if (it != mSlots.end())
+                mSlots.erase(it);
+        }
+
+        Snapshot Take()
+        {
+            std::lock_guard lock{mMutex};
+            Snapshot snapshot = mRetired;
+            for (const auto& slot : mSlots)
+                slot->Load(snapshot);
+            return snapshot;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::vector<std::unique_ptr<Slot>> mSlots;
+        Snapshot mRetired;
+    };
+
+    /**
+     * Блок счетчиков текущего потока (создается при первой записи).
+     */
+    inline Slot& LocalSlot()
+    {
+        struct Handle
+        {
+            Slot* mSlot = Registry::Instance().Attach();
+            ~Handle() { Registry::Instance().Detach(mSlot); }
+        };
+        thread_local Handle handle;
+        return *handle.mSlot;
+    }
+
+    /**
+     * Запись владельцем: других писателей у блока нет, поэтому достаточно load + store.
+     */
+    inline void Bump(std::atomic<uint64_t>& cell, uint64_t n)
+    {
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    inline void Add(Counter counter, uint64_t n = 1)
+    {
+        Bump(LocalSlot().mCounters[int(counter)], n);
+    }
+
+    inline void Record(Histogram histogram, uint64_t bucket)
+    {
+        Bump(LocalSlot().mHistograms[int(histogram)][std::min<uint64_t>(bucket, kBuckets - 1)], 1);
+    }
+
+    /**
+     * Снимок телеметрии всех потоков (при RSEXH_TELEMETRY=0 - нулевой).
+     */
+    inline Snapshot Take()
+    {
+#if RSEXH_TELEMETRY
+        return Registry::Instance().Take();
+#else
+        return {};
+#endif
+    }
+
+    inline constexpr bool IsEnabled()
+    {
+        return RSEXH_TELEMETRY != 0;
+    }
+
+    /**
+     * Время жизни области в гистограмму с логарифмическими корзинами (нс).
+     */
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram histogram) : mHistogram{histogram}, mStart{std::chrono::steady_clock::now()} {}
+
+        ~ScopedTimer()
+        {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count();
+            Record(mHistogram, std::bit_width(uint64_t(ns)));
+        }
+
+    private:
+        Histogram mHistogram;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    /**
+     * Краткая сводка снимка.
+     */
+    inline void Print(std::ostream& out, const Snapshot& s)
+    {
+        out << "inner words: " << s[Counter::InnerWords] << " (clean " << s.Rate(Counter::InnerClean, Counter::InnerWords)
+            << ", 1-error " << s.Rate(Counter::InnerCorrected1, Counter::InnerWords) << ", 2-error "
+            << s.Rate(Counter::InnerCorrected2, Counter::InnerWords) << ", failed " << s.Rate(Counter::InnerFailed, Counter::InnerWords)
+            << "), syndrome shift iterations: " << s[Counter::ShiftIterations]
+            << "\nouter blocks: " << s[Counter::OuterBlocks] << " (erasures per block "
+            << s.Rate(Counter::OuterErasures, Counter::OuterBlocks) << ", failures " << s[Counter::OuterFailures]
+            << ", miscorrections " << s[Counter::OuterMiscorrections] << "), decode latency p50/p99 < 2^"
+            << s.Percentile(Histogram::DecodeLatency, 0.5) << "/2^" << s.Percentile(Histogram::DecodeLatency, 0.99) << " ns\n";
+    }
+
+} // namespace telemetry
+
+#if RSEXH_TELEMETRY
+#define RSEXH_COUNT(counter, n) ::telemetry::Add(::telemetry::Counter::counter, (n))
+#define RSEXH_RECORD(histogram, bucket) ::telemetry::Record(::telemetry::Histogram::histogram, (bucket))
+#define RSEXH_TIME(histogram) const ::telemetry::ScopedTimer rsexh_scoped_timer{::telemetry::Histogram::histogram}
+#else
+#define RSEXH_COUNT(counter, n) ((void)0)
+#define RSEXH_RECORD(histogram, bucket) ((void)0)
+#define RSEXH_TIME(histogram) ((void)0)
+#endif
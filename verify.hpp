@@ -0,0 +1,157 @@
+/**
+ * Исчерпывающая проверка декодеров кода РС: все векторы 1- и 2-ошибок (все позиции, все ненулевые
+ * значения) на множестве случайных кодовых слов. Вариант декодера (прямая индексация, алгебраический,
+ * SIMD, ...) сравнивается с эталонным табличным RsExhT::Correct() по статусу и исправленному слову,
+ * а эталон - с истинным кодовым словом. Нужна перед заменой декодера в рабочем коде.
+ */
+
+#pragma once
+
+#include <cstdint>   // uint64_t
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono::steady_clock
+#include <mutex>     // std::mutex
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+#include <algorithm> // std::max
+#include <functional> // std::ref
+#include "rsexh.hpp"
+#include "channel.hpp"
+
+namespace verify {
+
+    struct Config
+    {
+        int mCodewords = 64;             // Случайных кодовых слов (первое - нулевое).
+        rsexh::CorrectionMode mMode = rsexh::CorrectionMode::Correct2;
+        uint64_t mSeed = 1;
+        int mThreads = 0;                // 0 - по числу аппаратных потоков.
+        int mMaxReported = 16;           // Сколько расхождений сохранить подробно.
+    };
+
+    /**
+     * Расхождение: вектор ошибки (вторая позиция -1 для 1-ошибки) на кодовом слове codeword.
+     */
+    struct Mismatch
+    {
+        int mCodeword = 0;
+        int mPos1 = 0;
+        int mValue1 = 0;
+        int mPos2 = -1;
+        int mValue2 = 0;
+        rsexh::InnerStatus mExpected{};
+        rsexh::InnerStatus mActual{};
+    };
+
+    struct Report
+    {
+        uint64_t mPatterns = 0;
+        uint64_t mMismatches = 0;        // Вариант разошелся с эталоном.
+        uint64_t mReferenceFailures = 0; // Эталон не восстановил кодовое слово, хотя должен был.
+        double mReferenceSeconds = 0.;   // Суммарное время вызовов декодеров по всем потокам.
+        double mVariantSeconds = 0.;
+        double mSeconds = 0.;            // Время прохода.
+        std::vector<Mismatch> mReported;
+
+        double PatternsPerSecond() const { return mSeconds > 0. ? mPatterns / mSeconds : 0.; }
+        double ReferenceNs() const { return mPatterns > 0 ? 1.e9 * mReferenceSeconds / mPatterns : 0.; }
+        double VariantNs() const { return mPatterns > 0 ? 1.e9 * mVariantSeconds / mPatterns : 0.; }
+    };
+
+    /**
+     * Прогнать эталон reference(v) и вариант variant(v) (оба: InnerStatus(std::vector<int>&)) на всех
+     * векторах ошибок веса <= t режима config.mMode. Задача - кодовое слово и позиция первой ошибки:
+     * пачка векторов сначала целиком декодируется эталоном, затем вариантом, и время каждого
+     * декодера меряется по пачке, а не по вызову.
+     */
+    template <typename Code, typename Reference, typename Variant>
+    Report Run(const Code& code, Reference&& reference, Variant&& variant, const Config& config)
+    {
+        constexpr int N = Code::N;
+        constexpr int K = Code::K;
+        const int t = int(config.mMode);
+        const auto start = std::chrono::steady_clock::now();
+        // Кодовые слова: информационные символы от счетчикового генератора, проверочные - таблицей кодирования.
+        std::vector<std::vector<int>> codewords(config.mCodewords, std::vector<int>(N, 0));
+        for (int c = 1; c < config.mCodewords; ++c) {
+            channel::CounterRng rng{config.mSeed, uint64_t(c)};
+            for (int j = 0; j < K; ++j)
+                codewords[c][j] = rng.Next() & N;
+            code.EncodeSystematic(codewords[c].data(), codewords[c].data() + K);
+        }
+        const auto& fast = code.mFast;
+        auto add_error = [&fast](int value, int error) { return fast.ToValue(fast.FromValue(value) ^ fast.FromValue(error)); };
+
+        Report report;
+        std::mutex reported_mutex;
+        const int threads = config.mThreads > 0 ? config.mThreads : std::max(1u, std::thread::hardware_concurrency());
+        const int tasks = t >= 1 ? config.mCodewords * N : 0;
+        std::atomic<int> next{0};
+        std::vector<Report> partial(threads);
+        auto work = [&](Report& local) {
+            std::vector<std::vector<int>> received;
+            std::vector<std::vector<int>> expected;
+            std::vector<rsexh::InnerStatus> statuses;
+            std::vector<Mismatch> patterns;
+            for (int task = next.fetch_add(1, std::memory_order_relaxed); task < tasks;
+                 task = next.fetch_add(1, std::memory_order_relaxed)) {
+                const int c = task / N;
+                const int i = task % N;
+                const auto& codeword = codewords[c];
+                patterns.clear();
+                for (int x = 1; x <= N; ++x) {
+                    patterns.push_back({c, i, x, -1, 0});
+                    for (int k = i + 1; k < N && t >= 2; ++k) {
+                        for (int y = 1; y <= N; ++y)
+                            patterns.push_back({c, i, x, k, y});
+                    }
+                }
+                received.resize(patterns.size());
+                for (std::size_t p = 0; p < patterns.size(); ++p) {
+                    received[p] = codeword;
+                    received[p][i] = add_error(codeword[i], patterns[p].mValue1);
+                    if (patterns[p].mPos2 >= 0)
+                        received[p][patterns[p].mPos2] = add_error(codeword[patterns[p].mPos2], patterns[p].mValue2);
+                }
+                expected = received;
+                statuses.resize(patterns.size());
+                const auto t0 = std::chrono::steady_clock::now();
+                for (std::size_t p = 0; p < patterns.size(); ++p)
+                    statuses[p] = reference(expected[p]);
+                const auto t1 = std::chrono::steady_clock::now();
+                for (std::size_t p = 0; p < patterns.size(); ++p)
+                    patterns[p].mActual = variant(received[p]);
+                const auto t2 = std::chrono::steady_clock::now();
+                local.mReferenceSeconds += std::chrono::duration<double>(t1 - t0).count();
+                local.mVariantSeconds += std::chrono::duration<double>(t2 - t1).count();
+                local.mPatterns += patterns.size();
+                for (std::size_t p = 0; p < patterns.size(); ++p) {
+                    local.mReferenceFailures += expected[p] != codeword;
+                    if (patterns[p].mActual == statuses[p] && received[p] == expected[p])
+                        continue;
+                    local.mMismatches++;
+                    patterns[p].mExpected = statuses[p];
+                    std::lock_guard lock{reported_mutex};
+                    if (int(report.mReported.size()) < config.mMaxReported)
+                        report.mReported.push_back(patterns[p]);
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int w = 1; w < threads; ++w)
+            pool.emplace_back(work, std::ref(partial[w]));
+        work(partial[0]);
+        for (auto& thread : pool)
+            thread.join();
+        for (const auto& local : partial) {
+            report.mPatterns += local.mPatterns;
+            report.mMismatches += local.mMismatches;
+            report.mReferenceFailures += local.mReferenceFailures;
+            report.mReferenceSeconds += local.mReferenceSeconds;
+            report.mVariantSeconds += local.mVariantSeconds;
+        }
+        report.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+} // namespace verify
@@ -0,0 +1,66 @@
+/**
+ * Широкое сложение (XOR) с накоплением на месте: dst ^= src для блоков памяти произвольной длины.
+ * Используются векторные регистры AVX-512 или AVX2, если сборка под них разрешена, иначе - 64-битные слова.
+ */
+
+#pragma once
+
+#include <cstdint>     // uint8_t, uint64_t
+#include <cstddef>     // std::size_t
+#include <cstring>     // std::memcpy
+#include <array>       // std::array
+#include <type_traits> // std::is_integral_v
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace hamming {
+
+    /**
+     * dst[i] ^= src[i], i = 0..bytes-1. Области не должны перекрываться, выравнивание не требуется.
+     */
+    inline void XorBytes(uint8_t* dst, const uint8_t* src, std::size_t bytes)
+    {
+        std::size_t i = 0;
+#if defined(__AVX512F__)
+        for (; i + 64 <= bytes; i += 64) {
+            const __m512i a = _mm512_loadu_si512(dst + i);
+            const __m512i b = _mm512_loadu_si512(src + i);
+            _mm512_storeu_si512(dst + i, _mm512_xor_si512(a, b));
+        }
+#endif
+#if defined(__AVX2__)
+        for (; i + 32 <= bytes; i += 32) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(a, b));
+        }
+#endif
+        for (; i + 8 <= bytes; i += 8) {
+            uint64_t a, b;
+            std::memcpy(&a, dst + i, 8);
+            std::memcpy(&b, src + i, 8);
+            a ^= b;
+            std::memcpy(dst + i, &a, 8);
+        }
+        for (; i < bytes; ++i)
+            dst[i] ^= src[i];
+    }
+
+    /**
+     * dst ^= src поэлементно. Короткие массивы - простым циклом (его векторизует компилятор),
+     * длинные - ядром XorBytes.
+     */
+    template <typename T, std::size_t N>
+    inline void XorInto(std::array<T, N>& dst, const std::array<T, N>& src)
+    {
+        static_assert(std::is_integral_v<T>, "XOR is defined for integral lanes only");
+        if constexpr (sizeof(T) * N < 64) {
+            for (std::size_t i = 0; i < N; ++i)
+                dst[i] ^= src[i];
+        } else {
+            XorBytes(reinterpret_cast<uint8_t*>(dst.data()), reinterpret_cast<const uint8_t*>(src.data()), sizeof(T) * N);
+        }
+    }
+
+} // namespace hamming